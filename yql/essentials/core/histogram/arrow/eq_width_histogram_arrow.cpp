@@ -0,0 +1,280 @@
+#include "eq_width_histogram_arrow.h"
+
+#include <arrow/type_traits.h>
+#include <arrow/util/bit_run_reader.h>
+#include <arrow/util/decimal.h>
+
+namespace NKikimr {
+
+namespace {
+
+// Calls `func(position, length)` for every run of valid values of the given `array`.
+template <typename TFunc>
+void VisitValidRuns(const arrow::Array& array, TFunc&& func) {
+    if (!array.null_count()) {
+        if (array.length()) {
+            func(0, array.length());
+        }
+        return;
+    }
+    if (array.null_count() == array.length()) {
+        return;
+    }
+    arrow::internal::SetBitRunReader reader(array.null_bitmap_data(), array.offset(), array.length());
+    for (auto run = reader.NextRun(); run.length; run = reader.NextRun()) {
+        func(run.position, run.length);
+    }
+}
+
+// Returns the given `value` clamped to the range of `T`.
+template <typename T>
+T ClampTo(i64 value) {
+    if constexpr (std::is_floating_point_v<T>) {
+        return static_cast<T>(value);
+    } else {
+        if constexpr (std::is_unsigned_v<T>) {
+            if (value < 0) {
+                return 0;
+            }
+            if (static_cast<ui64>(value) > std::numeric_limits<T>::max()) {
+                return std::numeric_limits<T>::max();
+            }
+        } else {
+            value = std::clamp<i64>(value, std::numeric_limits<T>::min(), std::numeric_limits<T>::max());
+        }
+        return static_cast<T>(value);
+    }
+}
+
+i64 GetUnitsPerSecond(arrow::TimeUnit::type unit) {
+    switch (unit) {
+        case arrow::TimeUnit::SECOND:
+            return 1;
+        case arrow::TimeUnit::MILLI:
+            return 1000;
+        case arrow::TimeUnit::MICRO:
+            return 1000000;
+        case arrow::TimeUnit::NANO:
+            return 1000000000;
+    }
+    Y_ABORT("Unknown arrow time unit");
+}
+
+// Converts the given `value` in `from` units to `to` units, saturates on overflow.
+i64 ConvertTimeUnit(i64 value, i64 from, i64 to) {
+    if (from >= to) {
+        return value / (from / to);
+    }
+    i64 result;
+    if (__builtin_mul_overflow(value, to / from, &result)) {
+        return value < 0 ? std::numeric_limits<i64>::min() : std::numeric_limits<i64>::max();
+    }
+    return result;
+}
+
+// Adds values `get(i)` of the valid elements of the given `array` to a histogram. Values of the
+// whole array are gathered first and added by one call, so the batch lookup works on the whole
+// array. Elements with `skip(i)` are not added. Returns the number of skipped elements.
+template <typename T, typename TGet, typename TSkip>
+ui64 AddConvertedElements(TEqWidthHistogram& histogram, const arrow::Array& array, TGet&& get, TSkip&& skip) {
+    TVector<T> buffer;
+    buffer.reserve(array.length() - array.null_count());
+    ui64 numSkipped = 0;
+    VisitValidRuns(array, [&](i64 position, i64 length) {
+        for (i64 i = position; i < position + length; ++i) {
+            if (skip(i)) {
+                ++numSkipped;
+                continue;
+            }
+            buffer.push_back(get(i));
+        }
+    });
+    histogram.AddElements<T>(TArrayRef<const T>(buffer.data(), buffer.size()));
+    return numSkipped;
+}
+
+// Calls `visitor(get)` with the function `get(i)` returning the value of the element `i` of the
+// given `array` converted to the histogram `type`. Returns false if the array can not be converted.
+template <typename T, typename TVisitor>
+bool VisitConverter(EHistogramValueType type, const arrow::Array& array, TVisitor&& visitor) {
+    using TNativeArray = typename arrow::CTypeTraits<T>::ArrayType;
+    if (array.type_id() == TNativeArray::TypeClass::type_id) {
+        const T* values = static_cast<const TNativeArray&>(array).raw_values();
+        visitor([values](i64 i) { return values[i]; });
+        return true;
+    }
+
+    switch (type) {
+        case EHistogramValueType::Date:
+            if (array.type_id() == arrow::Type::DATE32) {
+                const auto& typed = static_cast<const arrow::Date32Array&>(array);
+                visitor([&typed](i64 i) { return ClampTo<T>(typed.Value(i)); });
+                return true;
+            }
+            break;
+        case EHistogramValueType::Datetime:
+        case EHistogramValueType::Timestamp: {
+            const i64 to = type == EHistogramValueType::Datetime ? 1 : 1000000;
+            if (array.type_id() == arrow::Type::DATE32) {
+                const auto& typed = static_cast<const arrow::Date32Array&>(array);
+                visitor([&typed, to](i64 i) { return ClampTo<T>(ConvertTimeUnit(typed.Value(i), 1, to * 86400)); });
+                return true;
+            }
+            if (array.type_id() == arrow::Type::DATE64) {
+                const auto& typed = static_cast<const arrow::Date64Array&>(array);
+                visitor([&typed, to](i64 i) { return ClampTo<T>(ConvertTimeUnit(typed.Value(i), 1000, to)); });
+                return true;
+            }
+            if (array.type_id() == arrow::Type::TIMESTAMP) {
+                const auto& typed = static_cast<const arrow::TimestampArray&>(array);
+                const i64 from = GetUnitsPerSecond(static_cast<const arrow::TimestampType&>(*array.type()).unit());
+                visitor([&typed, from, to](i64 i) { return ClampTo<T>(ConvertTimeUnit(typed.Value(i), from, to)); });
+                return true;
+            }
+            break;
+        }
+        case EHistogramValueType::Interval:
+            if (array.type_id() == arrow::Type::DURATION) {
+                const auto& typed = static_cast<const arrow::DurationArray&>(array);
+                const i64 from = GetUnitsPerSecond(static_cast<const arrow::DurationType&>(*array.type()).unit());
+                visitor([&typed, from](i64 i) { return ClampTo<T>(ConvertTimeUnit(typed.Value(i), from, 1000000)); });
+                return true;
+            }
+            break;
+        case EHistogramValueType::Decimal:
+            if (array.type_id() == arrow::Type::DECIMAL128) {
+                const auto& typed = static_cast<const arrow::Decimal128Array&>(array);
+                const i32 scale = static_cast<const arrow::Decimal128Type&>(*array.type()).scale();
+                visitor([&typed, scale](i64 i) {
+                    return static_cast<T>(arrow::Decimal128(typed.GetValue(i)).ToDouble(scale));
+                });
+                return true;
+            }
+            break;
+        case EHistogramValueType::String:
+            if constexpr (std::is_same_v<T, ui64>) {
+                switch (array.type_id()) {
+                    case arrow::Type::STRING:
+                    case arrow::Type::BINARY: {
+                        const auto& typed = static_cast<const arrow::BinaryArray&>(array);
+                        visitor([&typed](i64 i) {
+                            const auto view = typed.GetView(i);
+                            return StringToHistogramValue(TStringBuf(view.data(), view.size()));
+                        });
+                        return true;
+                    }
+                    case arrow::Type::LARGE_STRING:
+                    case arrow::Type::LARGE_BINARY: {
+                        const auto& typed = static_cast<const arrow::LargeBinaryArray&>(array);
+                        visitor([&typed](i64 i) {
+                            const auto view = typed.GetView(i);
+                            return StringToHistogramValue(TStringBuf(view.data(), view.size()));
+                        });
+                        return true;
+                    }
+                    case arrow::Type::FIXED_SIZE_BINARY: {
+                        const auto& typed = static_cast<const arrow::FixedSizeBinaryArray&>(array);
+                        visitor([&typed](i64 i) {
+                            const auto view = typed.GetView(i);
+                            return StringToHistogramValue(TStringBuf(view.data(), view.size()));
+                        });
+                        return true;
+                    }
+                    default:
+                        break;
+                }
+            }
+            break;
+        default:
+            break;
+    }
+    return false;
+}
+
+// Calls `visitor(index)` with the function `index(i)` returning the dictionary index of the element
+// `i` of the given `indices`.
+template <typename TVisitor>
+void VisitDictionaryIndices(const arrow::Array& indices, TVisitor&& visitor) {
+    switch (indices.type_id()) {
+#define HISTOGRAM_DICTIONARY_INDEX(type, TArray)                                      \
+    case arrow::Type::type: {                                                         \
+        const auto* values = static_cast<const arrow::TArray&>(indices).raw_values(); \
+        visitor([values](i64 i) { return static_cast<i64>(values[i]); });             \
+        return;                                                                       \
+    }
+        HISTOGRAM_DICTIONARY_INDEX(INT8, Int8Array)
+        HISTOGRAM_DICTIONARY_INDEX(INT16, Int16Array)
+        HISTOGRAM_DICTIONARY_INDEX(INT32, Int32Array)
+        HISTOGRAM_DICTIONARY_INDEX(INT64, Int64Array)
+        HISTOGRAM_DICTIONARY_INDEX(UINT8, UInt8Array)
+        HISTOGRAM_DICTIONARY_INDEX(UINT16, UInt16Array)
+        HISTOGRAM_DICTIONARY_INDEX(UINT32, UInt32Array)
+        HISTOGRAM_DICTIONARY_INDEX(UINT64, UInt64Array)
+#undef HISTOGRAM_DICTIONARY_INDEX
+        default:
+            Y_ABORT("Arrow dictionary index type is not supported");
+    }
+}
+
+template <typename T>
+ui64 AddTypedElements(TEqWidthHistogram& histogram, const arrow::Array& array) {
+    using TNativeArray = typename arrow::CTypeTraits<T>::ArrayType;
+    if (array.type_id() == TNativeArray::TypeClass::type_id) {
+        // Values without nulls are added as is, otherwise valid values are gathered.
+        const T* values = static_cast<const TNativeArray&>(array).raw_values();
+        if (!array.null_count()) {
+            histogram.AddElements<T>(TArrayRef<const T>(values, array.length()));
+        } else {
+            AddConvertedElements<T>(histogram, array, [values](i64 i) { return values[i]; }, [](i64) { return false; });
+        }
+        return array.null_count();
+    }
+
+    if (array.type_id() == arrow::Type::DICTIONARY) {
+        // Dictionary values are converted once, nulls of the dictionary are counted as nulls.
+        const auto& dictionaryArray = static_cast<const arrow::DictionaryArray&>(array);
+        const auto& dictionary = *dictionaryArray.dictionary();
+        TVector<T> values(dictionary.length());
+        TVector<bool> valid(dictionary.length());
+        const bool converted = VisitConverter<T>(histogram.GetType(), dictionary, [&](auto&& get) {
+            for (i64 i = 0; i < dictionary.length(); ++i) {
+                valid[i] = dictionary.IsValid(i);
+                values[i] = valid[i] ? get(i) : T();
+            }
+        });
+        if (!converted) {
+            Y_ABORT("Arrow dictionary value type does not match the histogram type");
+        }
+        const auto& indices = *dictionaryArray.indices();
+        ui64 numNulls = indices.null_count();
+        VisitDictionaryIndices(indices, [&](auto&& index) {
+            numNulls += AddConvertedElements<T>(
+                histogram, indices, [&](i64 i) { return values[index(i)]; },
+                [&](i64 i) { return !valid[index(i)]; });
+        });
+        return numNulls;
+    }
+
+    ui64 numNulls = array.null_count();
+    const bool converted = VisitConverter<T>(histogram.GetType(), array, [&](auto&& get) {
+        AddConvertedElements<T>(histogram, array, get, [](i64) { return false; });
+    });
+    if (!converted) {
+        Y_ABORT("Arrow array type does not match the histogram type");
+    }
+    return numNulls;
+}
+
+} // namespace
+
+ui64 AddElements(TEqWidthHistogram& histogram, const arrow::Array& array) {
+    if (array.type_id() == arrow::Type::NA) {
+        return array.length();
+    }
+    return VisitHistogramValueType(histogram.GetType(), [&](auto tag) {
+        using T = typename decltype(tag)::type;
+        return AddTypedElements<T>(histogram, array);
+    });
+}
+
+} // namespace NKikimr
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <yql/essentials/core/histogram/eq_width_histogram.h>
+
+#include <arrow/array.h>
+#include <arrow/chunked_array.h>
+#include <arrow/record_batch.h>
+
+namespace NKikimr {
+
+// Adds all non-null values of the given arrow `array` to a histogram, returns the number of nulls.
+// Values of an array are added by one `TEqWidthHistogram::AddElements()` call. Arrays of the physical
+// type of the histogram values without nulls are added without a copy, valid values of other arrays
+// are gathered into a buffer first. Other arrays are converted to the histogram type:
+// `date32` to `Date`; `date32`, `date64` and `timestamp` of any unit to `Datetime` and `Timestamp`;
+// `duration` of any unit to `Interval`; `decimal128` to `Decimal`; `string`, `binary`, their large
+// variants and `fixed_size_binary` to `String`. Out of range values are clamped.
+// Dictionary arrays of any index type are added by converting the dictionary once, null values of
+// the dictionary are counted as nulls. Arrays of the `null` type are all nulls.
+// Aborts if the array type can not be converted to the histogram type.
+ui64 AddElements(TEqWidthHistogram& histogram, const arrow::Array& array);
+
+// Builds a histogram from arrow arrays of a column, e.g. as a side effect of a column shard scan or
+// compaction, and counts nulls and rows as statistics of the column.
+class TEqWidthHistogramArrowBuilder {
+public:
+    // Values are counted into the `histogram`, its counts are kept.
+    explicit TEqWidthHistogramArrowBuilder(TEqWidthHistogram histogram)
+        : Histogram_(std::move(histogram))
+    {
+    }
+
+    void AddArray(const arrow::Array& array) {
+        NullCount_ += AddElements(Histogram_, array);
+        NumRows_ += array.length();
+    }
+    void AddChunkedArray(const arrow::ChunkedArray& array) {
+        for (const auto& chunk : array.chunks()) {
+            AddArray(*chunk);
+        }
+    }
+    // Adds the column by the given `index` of the `batch`.
+    void AddRecordBatch(const arrow::RecordBatch& batch, int index) {
+        AddArray(*batch.column(index));
+    }
+
+    // Returns the number of added rows, nulls including.
+    ui64 GetNumRows() const {
+        return NumRows_;
+    }
+    ui64 GetNullCount() const {
+        return NullCount_;
+    }
+    const TEqWidthHistogram& GetHistogram() const {
+        return Histogram_;
+    }
+    // Returns the built histogram, the builder must not be used after that.
+    TEqWidthHistogram Finish() {
+        return std::move(Histogram_);
+    }
+
+private:
+    TEqWidthHistogram Histogram_;
+    ui64 NumRows_{0};
+    ui64 NullCount_{0};
+};
+
+} // namespace NKikimr
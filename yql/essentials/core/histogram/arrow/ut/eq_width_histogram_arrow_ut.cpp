@@ -0,0 +1,260 @@
+#include <yql/essentials/core/histogram/arrow/eq_width_histogram_arrow.h>
+
+#include <library/cpp/testing/unittest/registar.h>
+
+#include <arrow/builder.h>
+
+#include <optional>
+
+namespace NKikimr {
+
+namespace {
+
+template <typename T>
+TEqWidthHistogram MakeHistogram(EHistogramValueType type, T min, T max) {
+    const auto starts = NPrivate::MakeEqWidthStarts<T>(min, max, 16);
+    const TVector<ui64> counts(starts.size());
+    return TEqWidthHistogram(type, TArrayRef<const T>(starts), TArrayRef<const ui64>(counts));
+}
+
+// Returns an array of the given `values`, `std::nullopt` are nulls.
+template <typename TValue, typename TBuilder>
+std::shared_ptr<arrow::Array> BuildArray(TBuilder& builder, const TVector<std::optional<TValue>>& values) {
+    for (const auto& val : values) {
+        UNIT_ASSERT((val ? builder.Append(*val) : builder.AppendNull()).ok());
+    }
+    std::shared_ptr<arrow::Array> array;
+    UNIT_ASSERT(builder.Finish(&array).ok());
+    return array;
+}
+
+std::shared_ptr<arrow::Array> MakeDictionary(std::shared_ptr<arrow::Array> indices, std::shared_ptr<arrow::Array> dictionary) {
+    return arrow::DictionaryArray::FromArrays(arrow::dictionary(indices->type(), dictionary->type()), indices, dictionary).ValueOrDie();
+}
+
+// Checks that one `AddElements()` call with the `array` counts as many `AddElement()` calls with the
+// `expected` values do, `std::nullopt` are nulls.
+template <typename T>
+void CheckMatchesScalar(const TEqWidthHistogram& layout, const arrow::Array& array, const TVector<std::optional<T>>& expected) {
+    UNIT_ASSERT_VALUES_EQUAL(static_cast<size_t>(array.length()), expected.size());
+    TEqWidthHistogram scalar(layout);
+    ui64 numNulls = 0;
+    for (const auto& val : expected) {
+        if (val) {
+            scalar.AddElement<T>(*val);
+        } else {
+            ++numNulls;
+        }
+    }
+    TEqWidthHistogram batch(layout);
+    UNIT_ASSERT_VALUES_EQUAL(AddElements(batch, array), numNulls);
+    for (ui32 i = 0; i < layout.GetNumBuckets(); ++i) {
+        UNIT_ASSERT_VALUES_EQUAL(batch.GetNumElementsInBucket(i), scalar.GetNumElementsInBucket(i));
+    }
+}
+
+template <typename T>
+TVector<std::optional<T>> Slice(const TVector<std::optional<T>>& values, size_t offset, size_t length) {
+    return TVector<std::optional<T>>(values.begin() + offset, values.begin() + offset + length);
+}
+
+} // namespace
+
+Y_UNIT_TEST_SUITE(EqWidthHistogramArrow) {
+    Y_UNIT_TEST(NativeValues) {
+        const auto layout = MakeHistogram<i32>(EHistogramValueType::Int32, -100, 100);
+        for (const TVector<std::optional<i32>> values : {TVector<std::optional<i32>>{-100, 0, 5, 5, 99, 1000},
+                                                        TVector<std::optional<i32>>{std::nullopt, -7, std::nullopt, 42, -1000}}) {
+            arrow::Int32Builder builder;
+            CheckMatchesScalar<i32>(layout, *BuildArray<i32>(builder, values), values);
+        }
+
+        const TVector<std::optional<double>> doubles = {0.5, std::nullopt, -0.25, 0.75, 2.0};
+        arrow::DoubleBuilder builder;
+        CheckMatchesScalar<double>(MakeHistogram<double>(EHistogramValueType::Double, -1.0, 1.0), *BuildArray<double>(builder, doubles), doubles);
+    }
+
+    Y_UNIT_TEST(DateAndTimeUnits) {
+        const TVector<std::optional<i32>> days = {0, 1, std::nullopt, 365, 19000};
+        {
+            arrow::Date32Builder builder;
+            const auto array = BuildArray<i32>(builder, days);
+            CheckMatchesScalar<ui16>(MakeHistogram<ui16>(EHistogramValueType::Date, 0, 20000), *array, {0, 1, std::nullopt, 365, 19000});
+            CheckMatchesScalar<ui32>(MakeHistogram<ui32>(EHistogramValueType::Datetime, 0, 2000000000), *array,
+                                     {0, 86400, std::nullopt, 365 * 86400, 19000 * 86400});
+        }
+        {
+            arrow::Date64Builder builder;
+            const auto array = BuildArray<i64>(builder, {0, 1600000000123, std::nullopt, 86400000});
+            CheckMatchesScalar<ui32>(MakeHistogram<ui32>(EHistogramValueType::Datetime, 0, 2000000000), *array,
+                                     {0, 1600000000, std::nullopt, 86400});
+        }
+
+        // The same moments in every unit.
+        const auto timestamps = MakeHistogram<ui64>(EHistogramValueType::Timestamp, 0, 2000000000000000);
+        const auto datetimes = MakeHistogram<ui32>(EHistogramValueType::Datetime, 0, 2000000000);
+        const TVector<std::optional<ui64>> micros = {0, 1600000000123456, std::nullopt, 1700000000000000, 1000000};
+        const TVector<std::optional<ui32>> seconds = {0, 1600000000, std::nullopt, 1700000000, 1};
+        const std::pair<arrow::TimeUnit::type, TVector<std::optional<i64>>> units[] = {
+            {arrow::TimeUnit::SECOND, {0, 1600000000, std::nullopt, 1700000000, 1}},
+            {arrow::TimeUnit::MILLI, {0, 1600000000123, std::nullopt, 1700000000000, 1000}},
+            {arrow::TimeUnit::MICRO, {0, 1600000000123456, std::nullopt, 1700000000000000, 1000000}},
+            {arrow::TimeUnit::NANO, {0, 1600000000123456789, std::nullopt, 1700000000000000000, 1000000000}},
+        };
+        for (const auto& [unit, values] : units) {
+            arrow::TimestampBuilder builder(arrow::timestamp(unit), arrow::default_memory_pool());
+            const auto array = BuildArray<i64>(builder, values);
+            TVector<std::optional<ui64>> expected = micros;
+            if (unit == arrow::TimeUnit::SECOND) {
+                expected[1] = 1600000000000000;
+            } else if (unit == arrow::TimeUnit::MILLI) {
+                expected[1] = 1600000000123000;
+            }
+            CheckMatchesScalar<ui64>(timestamps, *array, expected);
+            CheckMatchesScalar<ui32>(datetimes, *array, seconds);
+        }
+
+        const auto intervals = MakeHistogram<i64>(EHistogramValueType::Interval, -10000000, 10000000);
+        const std::pair<arrow::TimeUnit::type, TVector<std::optional<i64>>> durations[] = {
+            {arrow::TimeUnit::SECOND, {-3, std::nullopt, 3, 0}},
+            {arrow::TimeUnit::MILLI, {-3000, std::nullopt, 3000, 0}},
+            {arrow::TimeUnit::MICRO, {-3000000, std::nullopt, 3000000, 0}},
+            {arrow::TimeUnit::NANO, {-3000000000, std::nullopt, 3000000000, 0}},
+        };
+        for (const auto& [unit, values] : durations) {
+            arrow::DurationBuilder builder(arrow::duration(unit), arrow::default_memory_pool());
+            CheckMatchesScalar<i64>(intervals, *BuildArray<i64>(builder, values), {-3000000, std::nullopt, 3000000, 0});
+        }
+    }
+
+    Y_UNIT_TEST(DecimalValues) {
+        arrow::Decimal128Builder builder(arrow::decimal128(10, 2), arrow::default_memory_pool());
+        const auto array = BuildArray<i64>(builder, {12345, -250, std::nullopt, 99999, 1});
+        CheckMatchesScalar<double>(MakeHistogram<double>(EHistogramValueType::Decimal, -1000.0, 1000.0), *array,
+                                   {DecimalToHistogramValue(12345, 2), DecimalToHistogramValue(-250, 2), std::nullopt,
+                                    DecimalToHistogramValue(99999, 2), DecimalToHistogramValue(1, 2)});
+    }
+
+    Y_UNIT_TEST(StringValues) {
+        const auto layout = MakeHistogram<ui64>(EHistogramValueType::String, 0, std::numeric_limits<ui64>::max());
+        const TVector<std::optional<std::string_view>> strings = {"apple", "", std::nullopt, "zebra", "hello world", "\xff\xff"};
+        TVector<std::optional<ui64>> expected;
+        for (const auto& str : strings) {
+            expected.push_back(str ? std::make_optional(StringToHistogramValue(TStringBuf(str->data(), str->size()))) : std::nullopt);
+        }
+        {
+            arrow::StringBuilder builder;
+            CheckMatchesScalar<ui64>(layout, *BuildArray<std::string_view>(builder, strings), expected);
+        }
+        {
+            arrow::LargeStringBuilder builder;
+            CheckMatchesScalar<ui64>(layout, *BuildArray<std::string_view>(builder, strings), expected);
+        }
+        {
+            arrow::BinaryBuilder builder;
+            CheckMatchesScalar<ui64>(layout, *BuildArray<std::string_view>(builder, strings), expected);
+        }
+        {
+            arrow::FixedSizeBinaryBuilder builder(arrow::fixed_size_binary(3), arrow::default_memory_pool());
+            CheckMatchesScalar<ui64>(layout, *BuildArray<std::string_view>(builder, {"abc", std::nullopt, "zzz", std::string_view("ab\0", 3)}),
+                                     {StringToHistogramValue("abc"), std::nullopt, StringToHistogramValue("zzz"),
+                                      StringToHistogramValue(TStringBuf("ab\0", 3))});
+        }
+    }
+
+    Y_UNIT_TEST(DictionaryArrays) {
+        // Null values of the dictionary are nulls as well as null indices.
+        arrow::StringBuilder strings;
+        const auto dictionary = BuildArray<std::string_view>(strings, {"b", std::nullopt, "a", "zz"});
+        arrow::Int8Builder indices;
+        const auto array = MakeDictionary(BuildArray<i64>(indices, {0, 1, 2, std::nullopt, 3, 1, 0}), dictionary);
+        const auto b = StringToHistogramValue("b");
+        CheckMatchesScalar<ui64>(MakeHistogram<ui64>(EHistogramValueType::String, 0, std::numeric_limits<ui64>::max()), *array,
+                                 {b, std::nullopt, StringToHistogramValue("a"), std::nullopt, StringToHistogramValue("zz"), std::nullopt, b});
+
+        arrow::Int32Builder ints;
+        const auto intDictionary = BuildArray<i32>(ints, {10, 20, std::nullopt, -5});
+        arrow::UInt16Builder wideIndices;
+        CheckMatchesScalar<i32>(MakeHistogram<i32>(EHistogramValueType::Int32, -10, 30),
+                                *MakeDictionary(BuildArray<i64>(wideIndices, {3, 3, 2, 0, std::nullopt, 1}), intDictionary),
+                                {-5, -5, std::nullopt, 10, std::nullopt, 20});
+
+        // Dictionary values are converted to the histogram type.
+        arrow::Date32Builder dates;
+        const auto dateDictionary = BuildArray<i32>(dates, {1, 2});
+        arrow::Int32Builder dateIndices;
+        CheckMatchesScalar<ui32>(MakeHistogram<ui32>(EHistogramValueType::Datetime, 0, 1000000),
+                                 *MakeDictionary(BuildArray<i64>(dateIndices, {1, 0, 1}), dateDictionary), {2 * 86400, 86400, 2 * 86400});
+    }
+
+    Y_UNIT_TEST(SlicedArrays) {
+        TVector<std::optional<i32>> values;
+        for (i32 i = 0; i < 100; ++i) {
+            values.push_back(i % 7 == 3 ? std::nullopt : std::make_optional(i * 3 - 100));
+        }
+        arrow::Int32Builder builder;
+        const auto array = BuildArray<i32>(builder, values);
+        const auto layout = MakeHistogram<i32>(EHistogramValueType::Int32, -100, 200);
+        for (const auto& [offset, length] : {std::pair<size_t, size_t>{13, 50}, {1, 99}, {64, 36}, {3, 1}, {4, 6}, {50, 0}}) {
+            CheckMatchesScalar<i32>(layout, *array->Slice(offset, length), Slice(values, offset, length));
+        }
+
+        // Valid values are converted and gathered from the offset as well.
+        TVector<std::optional<i64>> millis;
+        TVector<std::optional<ui32>> seconds;
+        for (i64 i = 0; i < 40; ++i) {
+            millis.push_back(i % 5 ? std::make_optional(i * 1000) : std::nullopt);
+            seconds.push_back(i % 5 ? std::make_optional(static_cast<ui32>(i)) : std::nullopt);
+        }
+        arrow::TimestampBuilder timestamps(arrow::timestamp(arrow::TimeUnit::MILLI), arrow::default_memory_pool());
+        const auto timestampArray = BuildArray<i64>(timestamps, millis);
+        CheckMatchesScalar<ui32>(MakeHistogram<ui32>(EHistogramValueType::Datetime, 0, 100), *timestampArray->Slice(7, 30), Slice(seconds, 7, 30));
+
+        arrow::StringBuilder strings;
+        const auto dictionary = BuildArray<std::string_view>(strings, {"a", std::nullopt, "c"});
+        TVector<std::optional<i64>> indices;
+        TVector<std::optional<ui64>> expected;
+        for (i64 i = 0; i < 30; ++i) {
+            indices.push_back(i % 4 == 3 ? std::nullopt : std::make_optional(i % 3));
+            const bool valid = i % 4 != 3 && i % 3 != 1;
+            expected.push_back(valid ? std::make_optional(StringToHistogramValue(i % 3 ? "c" : "a")) : std::nullopt);
+        }
+        arrow::Int16Builder indexBuilder;
+        const auto dictionaryArray = MakeDictionary(BuildArray<i64>(indexBuilder, indices), dictionary);
+        CheckMatchesScalar<ui64>(MakeHistogram<ui64>(EHistogramValueType::String, 0, std::numeric_limits<ui64>::max()),
+                                 *dictionaryArray->Slice(5, 20), Slice(expected, 5, 20));
+    }
+
+    Y_UNIT_TEST(AllNulls) {
+        const auto layout = MakeHistogram<i32>(EHistogramValueType::Int32, 0, 99);
+        arrow::Int32Builder builder;
+        const TVector<std::optional<i32>> nulls(10);
+        CheckMatchesScalar<i32>(layout, *BuildArray<i32>(builder, nulls), nulls);
+        CheckMatchesScalar<i32>(layout, arrow::NullArray(5), TVector<std::optional<i32>>(5));
+
+        arrow::StringBuilder strings;
+        CheckMatchesScalar<ui64>(MakeHistogram<ui64>(EHistogramValueType::String, 0, std::numeric_limits<ui64>::max()),
+                                 *BuildArray<std::string_view>(strings, TVector<std::optional<std::string_view>>(4)),
+                                 TVector<std::optional<ui64>>(4));
+
+        arrow::Int32Builder dictionaryBuilder;
+        const auto dictionary = BuildArray<i32>(dictionaryBuilder, {std::nullopt, std::nullopt});
+        arrow::Int8Builder indices;
+        CheckMatchesScalar<i32>(layout, *MakeDictionary(BuildArray<i64>(indices, {0, 1, std::nullopt, 1}), dictionary),
+                                TVector<std::optional<i32>>(4));
+    }
+
+    Y_UNIT_TEST(ArrowBuilder) {
+        arrow::Int32Builder builder;
+        const auto first = BuildArray<i32>(builder, {1, std::nullopt, 50});
+        const auto second = BuildArray<i32>(builder, {std::nullopt, std::nullopt, 99, 0});
+        TEqWidthHistogramArrowBuilder histogramBuilder(MakeHistogram<i32>(EHistogramValueType::Int32, 0, 99));
+        histogramBuilder.AddChunkedArray(arrow::ChunkedArray({first, second}));
+        histogramBuilder.AddArray(arrow::NullArray(2));
+        UNIT_ASSERT_VALUES_EQUAL(histogramBuilder.GetNumRows(), 9);
+        UNIT_ASSERT_VALUES_EQUAL(histogramBuilder.GetNullCount(), 5);
+        UNIT_ASSERT_VALUES_EQUAL(TEqWidthHistogramEstimator(std::make_shared<TEqWidthHistogram>(histogramBuilder.Finish())).GetNumElements(), 4);
+    }
+}
+
+} // namespace NKikimr
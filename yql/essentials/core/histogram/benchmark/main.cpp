@@ -0,0 +1,396 @@
+#include <yql/essentials/core/histogram/eq_width_histogram.h>
+
+#include <benchmark/benchmark.h>
+
+#include <util/generic/vector.h>
+
+#include <random>
+
+namespace NKikimr {
+
+namespace {
+
+// The number of values added or looked up per iteration.
+constexpr ui32 NumValues = 1 << 16;
+
+enum EDistribution {
+    Uniform = 0,
+    Zipfian = 1,
+    Sorted = 2,
+};
+
+enum EEstimate {
+    LessOrEqual = 0,
+    Less = 1,
+    GreaterOrEqual = 2,
+    Greater = 3,
+    Equal = 4,
+    Range = 5,
+};
+
+// Returns values of the given `distribution` within the type range.
+template <typename T, EHistogramValueType Type>
+TVector<T> GenerateValues(EDistribution distribution, ui64 seed = 1) {
+    constexpr double maxValue = std::min<double>(1'000'000, static_cast<double>(std::numeric_limits<T>::max()));
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    TVector<T> values(NumValues);
+    for (auto& val : values) {
+        double x = uniform(rng);
+        if (distribution == Zipfian) {
+            // Zipf-like with the exponent 1: ranks are log-uniformly distributed.
+            x = (std::exp(x * std::log(maxValue + 1)) - 1) / maxValue;
+        }
+        if constexpr (Type == EHistogramValueType::String) {
+            // Strings of lowercase letters spelling the rank in base 26, so the order and the
+            // distribution of ranks are kept.
+            char str[8];
+            auto rank = static_cast<ui64>(x * maxValue);
+            for (size_t i = sizeof(str); i > 0; --i, rank /= 26) {
+                str[i - 1] = 'a' + rank % 26;
+            }
+            val = StringToHistogramValue(TStringBuf(str, sizeof(str)));
+        } else {
+            val = static_cast<T>(x * maxValue);
+        }
+    }
+    if (distribution == Sorted) {
+        std::sort(values.begin(), values.end());
+    }
+    return values;
+}
+
+// Returns an empty histogram of `numBuckets` equal-width buckets covering the given `values`.
+template <typename T, EHistogramValueType Type>
+TEqWidthHistogram MakeHistogram(const TVector<T>& values, ui32 numBuckets) {
+    const auto [min, max] = std::minmax_element(values.begin(), values.end());
+    const auto starts = NPrivate::MakeEqWidthStarts<T>(*min, *max, numBuckets);
+    const TVector<ui64> counts(starts.size());
+    return TEqWidthHistogram(Type, TArrayRef<const T>(starts.data(), starts.size()), TArrayRef<const ui64>(counts.data(), counts.size()));
+}
+
+template <typename T, EHistogramValueType Type>
+TEqWidthHistogram MakeFilledHistogram(const TVector<T>& values, ui32 numBuckets) {
+    auto histogram = MakeHistogram<T, Type>(values, numBuckets);
+    histogram.template AddElements<T>(TArrayRef<const T>(values.data(), values.size()));
+    return histogram;
+}
+
+template <typename T, EHistogramValueType Type>
+void BM_AddElement(benchmark::State& state) {
+    const auto values = GenerateValues<T, Type>(static_cast<EDistribution>(state.range(1)));
+    auto histogram = MakeHistogram<T, Type>(values, state.range(0));
+    for (auto _ : state) {
+        for (const auto& val : values) {
+            histogram.template AddElement<T>(val);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+template <typename T, EHistogramValueType Type>
+void BM_AddElements(benchmark::State& state) {
+    const auto values = GenerateValues<T, Type>(static_cast<EDistribution>(state.range(1)));
+    auto histogram = MakeHistogram<T, Type>(values, state.range(0));
+    for (auto _ : state) {
+        histogram.template AddElements<T>(TArrayRef<const T>(values.data(), values.size()));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+template <typename T, EHistogramValueType Type>
+void BM_FindBucketIndex(benchmark::State& state) {
+    const auto values = GenerateValues<T, Type>(static_cast<EDistribution>(state.range(1)));
+    const auto histogram = MakeFilledHistogram<T, Type>(values, state.range(0));
+    for (auto _ : state) {
+        for (const auto& val : values) {
+            benchmark::DoNotOptimize(histogram.template FindBucketIndex<T>(val));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+template <typename T, EHistogramValueType Type>
+void BM_Estimate(benchmark::State& state) {
+    const auto values = GenerateValues<T, Type>(static_cast<EDistribution>(state.range(1)));
+    TEqWidthHistogramEstimator::TSettings settings;
+    settings.Interpolate = state.range(3);
+    TEqWidthHistogramEstimator estimator(std::make_shared<TEqWidthHistogram>(MakeFilledHistogram<T, Type>(values, state.range(0))), settings);
+    // Probe values in a different order than they were added.
+    const auto probes = GenerateValues<T, Type>(Uniform, 2);
+    const auto estimate = static_cast<EEstimate>(state.range(2));
+    for (auto _ : state) {
+        for (const auto& val : probes) {
+            switch (estimate) {
+                case LessOrEqual:
+                    benchmark::DoNotOptimize(estimator.EstimateLessOrEqual<T>(val));
+                    break;
+                case Less:
+                    benchmark::DoNotOptimize(estimator.EstimateLess<T>(val));
+                    break;
+                case GreaterOrEqual:
+                    benchmark::DoNotOptimize(estimator.EstimateGreaterOrEqual<T>(val));
+                    break;
+                case Greater:
+                    benchmark::DoNotOptimize(estimator.EstimateGreater<T>(val));
+                    break;
+                case Equal:
+                    benchmark::DoNotOptimize(estimator.EstimateEqual<T>(val));
+                    break;
+                case Range:
+                    benchmark::DoNotOptimize(estimator.EstimateRange<T>(val, val));
+                    break;
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * probes.size());
+}
+
+template <typename T, EHistogramValueType Type>
+void BM_EstimateBatch(benchmark::State& state) {
+    const auto values = GenerateValues<T, Type>(static_cast<EDistribution>(state.range(1)));
+    TEqWidthHistogramEstimator::TSettings settings;
+    settings.Interpolate = state.range(3);
+    TEqWidthHistogramEstimator estimator(std::make_shared<TEqWidthHistogram>(MakeFilledHistogram<T, Type>(values, state.range(0))), settings);
+    const auto probes = GenerateValues<T, Type>(Uniform, 2);
+    const TArrayRef<const T> probesRef(probes.data(), probes.size());
+    TVector<ui64> result(probes.size());
+    const TArrayRef<ui64> resultRef(result.data(), result.size());
+    const auto estimate = static_cast<EEstimate>(state.range(2));
+    for (auto _ : state) {
+        switch (estimate) {
+            case LessOrEqual:
+                estimator.EstimateLessOrEqualBatch<T>(probesRef, resultRef);
+                break;
+            case Less:
+                estimator.EstimateLessBatch<T>(probesRef, resultRef);
+                break;
+            case GreaterOrEqual:
+                estimator.EstimateGreaterOrEqualBatch<T>(probesRef, resultRef);
+                break;
+            case Greater:
+                estimator.EstimateGreaterBatch<T>(probesRef, resultRef);
+                break;
+            case Equal:
+                estimator.EstimateEqualBatch<T>(probesRef, resultRef);
+                break;
+            case Range:
+                // No batch version, see `EstimateBatchArgs()`.
+                break;
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * probes.size());
+}
+
+template <typename T, EHistogramValueType Type>
+void BM_EstimateWithBounds(benchmark::State& state) {
+    const auto values = GenerateValues<T, Type>(static_cast<EDistribution>(state.range(1)));
+    TEqWidthHistogramEstimator::TSettings settings;
+    settings.Interpolate = state.range(3);
+    TEqWidthHistogramEstimator estimator(std::make_shared<TEqWidthHistogram>(MakeFilledHistogram<T, Type>(values, state.range(0))), settings);
+    const auto probes = GenerateValues<T, Type>(Uniform, 2);
+    const auto estimate = static_cast<EEstimate>(state.range(2));
+    for (auto _ : state) {
+        for (const auto& val : probes) {
+            switch (estimate) {
+                case LessOrEqual:
+                    benchmark::DoNotOptimize(estimator.EstimateLessOrEqualWithBounds<T>(val));
+                    break;
+                case Less:
+                    benchmark::DoNotOptimize(estimator.EstimateLessWithBounds<T>(val));
+                    break;
+                case GreaterOrEqual:
+                    benchmark::DoNotOptimize(estimator.EstimateGreaterOrEqualWithBounds<T>(val));
+                    break;
+                case Greater:
+                    benchmark::DoNotOptimize(estimator.EstimateGreaterWithBounds<T>(val));
+                    break;
+                case Equal:
+                    benchmark::DoNotOptimize(estimator.EstimateEqualWithBounds<T>(val));
+                    break;
+                case Range:
+                    benchmark::DoNotOptimize(estimator.EstimateRangeWithBounds<T>(val, val));
+                    break;
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * probes.size());
+}
+
+// Adds values with the distinct counting, of the whole histogram and of every bucket if the
+// bucket precision is not zero.
+template <typename T, EHistogramValueType Type>
+void BM_AddElementsNdv(benchmark::State& state) {
+    const auto values = GenerateValues<T, Type>(static_cast<EDistribution>(state.range(1)));
+    auto histogram = MakeHistogram<T, Type>(values, state.range(0));
+    histogram.EnableNdv(10, state.range(2));
+    for (auto _ : state) {
+        histogram.template AddElements<T>(TArrayRef<const T>(values.data(), values.size()));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+// The equality estimate by the distinct counts, see `BM_AddElementsNdv`.
+template <typename T, EHistogramValueType Type>
+void BM_EstimateEqualNdv(benchmark::State& state) {
+    const auto values = GenerateValues<T, Type>(static_cast<EDistribution>(state.range(1)));
+    auto histogram = MakeHistogram<T, Type>(values, state.range(0));
+    histogram.EnableNdv(10, state.range(2));
+    histogram.template AddElements<T>(TArrayRef<const T>(values.data(), values.size()));
+    TEqWidthHistogramEstimator estimator(std::make_shared<TEqWidthHistogram>(std::move(histogram)));
+    const auto probes = GenerateValues<T, Type>(Uniform, 2);
+    for (auto _ : state) {
+        for (const auto& val : probes) {
+            benchmark::DoNotOptimize(estimator.EstimateEqual<T>(val));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * probes.size());
+}
+
+template <typename T, EHistogramValueType Type>
+void BM_Aggregate(benchmark::State& state) {
+    const auto distribution = static_cast<EDistribution>(state.range(1));
+    const auto values = GenerateValues<T, Type>(distribution);
+    const auto histogram = MakeFilledHistogram<T, Type>(values, state.range(0));
+    // The same layout, or a layout of other values, which is projected.
+    const auto other = state.range(2) ? MakeFilledHistogram<T, Type>(GenerateValues<T, Type>(distribution, 2), state.range(0)) : histogram;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto result = histogram;
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(result.template Aggregate<T>(other));
+    }
+    state.SetItemsProcessed(state.iterations() * histogram.GetNumBuckets());
+}
+
+template <typename T, EHistogramValueType Type>
+void BM_Serialize(benchmark::State& state) {
+    const auto values = GenerateValues<T, Type>(static_cast<EDistribution>(state.range(1)));
+    const auto histogram = MakeFilledHistogram<T, Type>(values, state.range(0));
+    const auto format = static_cast<EHistogramFormat>(state.range(2));
+    TVector<char> buffer(histogram.GetSerializedSize(format));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(histogram.SerializeTo(TArrayRef<char>(buffer.data(), buffer.size()), format));
+    }
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+
+template <typename T, EHistogramValueType Type>
+void BM_Deserialize(benchmark::State& state) {
+    const auto values = GenerateValues<T, Type>(static_cast<EDistribution>(state.range(1)));
+    const auto histogram = MakeFilledHistogram<T, Type>(values, state.range(0));
+    ui64 size = 0;
+    const auto data = histogram.Serialize(size, static_cast<EHistogramFormat>(state.range(2)));
+    for (auto _ : state) {
+        TEqWidthHistogram result(data.get(), size);
+        benchmark::DoNotOptimize(result.GetNumBuckets());
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+
+// Arguments: the number of buckets from 16 to 64K, the distribution.
+void BucketsAndDistributions(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgNames({"buckets", "distribution"});
+    for (i64 numBuckets = 16; numBuckets <= (64 << 10); numBuckets *= 8) {
+        for (i64 distribution : {Uniform, Zipfian, Sorted}) {
+            benchmark->Args({numBuckets, distribution});
+        }
+    }
+}
+
+// Additionally: every estimate, with and without the interpolation. Sorted values give the same
+// histogram as the uniform ones.
+void EstimateArgs(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgNames({"buckets", "distribution", "estimate", "interpolate"});
+    for (i64 numBuckets : {16, 1024, 64 << 10}) {
+        for (i64 distribution : {Uniform, Zipfian}) {
+            for (i64 estimate = LessOrEqual; estimate <= Range; ++estimate) {
+                for (i64 interpolate : {0, 1}) {
+                    benchmark->Args({numBuckets, distribution, estimate, interpolate});
+                }
+            }
+        }
+    }
+}
+
+// Additionally: every batch estimate, the range has no batch version.
+void EstimateBatchArgs(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgNames({"buckets", "distribution", "estimate", "interpolate"});
+    for (i64 numBuckets : {16, 1024, 64 << 10}) {
+        for (i64 distribution : {Uniform, Zipfian}) {
+            for (i64 estimate = LessOrEqual; estimate <= Equal; ++estimate) {
+                for (i64 interpolate : {0, 1}) {
+                    benchmark->Args({numBuckets, distribution, estimate, interpolate});
+                }
+            }
+        }
+    }
+}
+
+// Additionally: the precision of bucket sketches, zero for the only sketch of the whole histogram.
+void NdvArgs(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgNames({"buckets", "distribution", "bucket_precision"});
+    for (i64 numBuckets : {16, 1024}) {
+        for (i64 distribution : {Uniform, Zipfian}) {
+            for (i64 bucketPrecision : {0, 6}) {
+                benchmark->Args({numBuckets, distribution, bucketPrecision});
+            }
+        }
+    }
+}
+
+// Additionally: the same layouts or different ones.
+void AggregateArgs(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgNames({"buckets", "distribution", "projected"});
+    for (i64 numBuckets = 16; numBuckets <= (64 << 10); numBuckets *= 8) {
+        for (i64 projected : {0, 1}) {
+            benchmark->Args({numBuckets, Uniform, projected});
+        }
+    }
+}
+
+// Additionally: the binary format.
+void FormatArgs(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgNames({"buckets", "distribution", "format"});
+    for (i64 numBuckets = 16; numBuckets <= (64 << 10); numBuckets *= 8) {
+        for (auto format : {EHistogramFormat::V1, EHistogramFormat::V2}) {
+            benchmark->Args({numBuckets, Uniform, static_cast<i64>(format)});
+        }
+    }
+}
+
+} // namespace
+
+#define HISTOGRAM_BENCHMARK(name, args)                                                   \
+    BENCHMARK_TEMPLATE(name, i16, EHistogramValueType::Int16)->Apply(args);              \
+    BENCHMARK_TEMPLATE(name, i32, EHistogramValueType::Int32)->Apply(args);              \
+    BENCHMARK_TEMPLATE(name, i64, EHistogramValueType::Int64)->Apply(args);              \
+    BENCHMARK_TEMPLATE(name, ui16, EHistogramValueType::Uint16)->Apply(args);            \
+    BENCHMARK_TEMPLATE(name, ui32, EHistogramValueType::Uint32)->Apply(args);            \
+    BENCHMARK_TEMPLATE(name, ui64, EHistogramValueType::Uint64)->Apply(args);            \
+    BENCHMARK_TEMPLATE(name, double, EHistogramValueType::Double)->Apply(args);          \
+    BENCHMARK_TEMPLATE(name, float, EHistogramValueType::Float)->Apply(args);            \
+    BENCHMARK_TEMPLATE(name, ui16, EHistogramValueType::Date)->Apply(args);              \
+    BENCHMARK_TEMPLATE(name, ui32, EHistogramValueType::Datetime)->Apply(args);          \
+    BENCHMARK_TEMPLATE(name, ui64, EHistogramValueType::Timestamp)->Apply(args);         \
+    BENCHMARK_TEMPLATE(name, i64, EHistogramValueType::Interval)->Apply(args);           \
+    BENCHMARK_TEMPLATE(name, double, EHistogramValueType::Decimal)->Apply(args);         \
+    BENCHMARK_TEMPLATE(name, ui64, EHistogramValueType::String)->Apply(args)
+
+HISTOGRAM_BENCHMARK(BM_AddElement, BucketsAndDistributions);
+HISTOGRAM_BENCHMARK(BM_AddElements, BucketsAndDistributions);
+HISTOGRAM_BENCHMARK(BM_FindBucketIndex, BucketsAndDistributions);
+HISTOGRAM_BENCHMARK(BM_Estimate, EstimateArgs);
+HISTOGRAM_BENCHMARK(BM_EstimateBatch, EstimateBatchArgs);
+HISTOGRAM_BENCHMARK(BM_EstimateWithBounds, EstimateArgs);
+HISTOGRAM_BENCHMARK(BM_AddElementsNdv, NdvArgs);
+HISTOGRAM_BENCHMARK(BM_EstimateEqualNdv, NdvArgs);
+HISTOGRAM_BENCHMARK(BM_Aggregate, AggregateArgs);
+HISTOGRAM_BENCHMARK(BM_Serialize, FormatArgs);
+HISTOGRAM_BENCHMARK(BM_Deserialize, FormatArgs);
+
+} // namespace NKikimr
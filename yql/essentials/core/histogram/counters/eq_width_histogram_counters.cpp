@@ -0,0 +1,35 @@
+#include "eq_width_histogram_counters.h"
+
+#include <library/cpp/monlib/metrics/histogram_collector.h>
+
+#include <algorithm>
+
+namespace NKikimr {
+
+TEqWidthHistogramEstimatorCounters::TEqWidthHistogramEstimatorCounters(::NMonitoring::TDynamicCounterPtr counters)
+    : Lookups_(counters->GetCounter("EstimateLookups", true))
+    , Feedbacks_(counters->GetCounter("EstimateFeedbacks", true))
+    , Underestimates_(counters->GetCounter("EstimateUnderestimates", true))
+    , Overestimates_(counters->GetCounter("EstimateOverestimates", true))
+    // Buckets 1, 2, 4, ... 2^14 and the rest.
+    , QError_(counters->GetHistogram("EstimateQError", ::NMonitoring::ExponentialHistogram(16, 2, 1)))
+{
+}
+
+void TEqWidthHistogramEstimatorCounters::OnFeedback(ui64 estimate, ui64 actual) {
+    Feedbacks_->Inc();
+    if (estimate < actual) {
+        Underestimates_->Inc();
+    } else if (estimate > actual) {
+        Overestimates_->Inc();
+    }
+    QError_->Collect(GetQError(estimate, actual));
+}
+
+double TEqWidthHistogramEstimatorCounters::GetQError(ui64 estimate, ui64 actual) {
+    const double e = std::max<ui64>(estimate, 1);
+    const double a = std::max<ui64>(actual, 1);
+    return std::max(e / a, a / e);
+}
+
+} // namespace NKikimr
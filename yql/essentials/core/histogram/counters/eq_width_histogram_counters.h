@@ -0,0 +1,37 @@
+#pragma once
+
+#include <yql/essentials/core/histogram/eq_width_histogram.h>
+
+#include <library/cpp/monlib/dynamic_counters/counters.h>
+
+namespace NKikimr {
+
+// Monitoring counters of the estimates of a column, e.g. of
+// `counters->GetSubgroup("table", table)->GetSubgroup("column", column)`:
+// - `EstimateLookups`, the number of estimates, counted by estimators with `TSettings::Counters`,
+// - `EstimateFeedbacks`, the number of estimates compared with the actual numbers of rows reported
+//   by executed plans, and how many of them are under and overestimated,
+// - `EstimateQError`, the histogram of q-errors of the compared estimates, see `GetQError()`.
+// Columns with large q-errors are the ones where larger histograms pay for themselves.
+class TEqWidthHistogramEstimatorCounters final: public IEqWidthHistogramEstimatorCounters {
+public:
+    explicit TEqWidthHistogramEstimatorCounters(::NMonitoring::TDynamicCounterPtr counters);
+
+    void OnLookups(ui64 count) override {
+        Lookups_->Add(count);
+    }
+    // Records the `actual` number of rows for the `estimate`, e.g. from statistics of an executed plan.
+    void OnFeedback(ui64 estimate, ui64 actual);
+
+    // Returns max(estimate / actual, actual / estimate), zeros are taken as ones.
+    static double GetQError(ui64 estimate, ui64 actual);
+
+private:
+    ::NMonitoring::TDynamicCounters::TCounterPtr Lookups_;
+    ::NMonitoring::TDynamicCounters::TCounterPtr Feedbacks_;
+    ::NMonitoring::TDynamicCounters::TCounterPtr Underestimates_;
+    ::NMonitoring::TDynamicCounters::TCounterPtr Overestimates_;
+    ::NMonitoring::THistogramPtr QError_;
+};
+
+} // namespace NKikimr
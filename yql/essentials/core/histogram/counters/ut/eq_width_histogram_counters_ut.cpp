@@ -0,0 +1,83 @@
+#include <yql/essentials/core/histogram/counters/eq_width_histogram_counters.h>
+
+#include <library/cpp/monlib/metrics/histogram_collector.h>
+#include <library/cpp/testing/unittest/registar.h>
+
+#include <util/generic/ptr.h>
+
+namespace NKikimr {
+
+namespace {
+
+std::shared_ptr<TEqWidthHistogram> MakeHistogram() {
+    const auto starts = NPrivate::MakeEqWidthStarts<i32>(0, 99, 10);
+    const TVector<ui64> counts(starts.size());
+    auto histogram = std::make_shared<TEqWidthHistogram>(EHistogramValueType::Int32, TArrayRef<const i32>(starts), TArrayRef<const ui64>(counts));
+    for (i32 val = 0; val < 100; ++val) {
+        histogram->AddElement<i32>(val);
+    }
+    return histogram;
+}
+
+} // namespace
+
+Y_UNIT_TEST_SUITE(EqWidthHistogramEstimatorCounters) {
+    Y_UNIT_TEST(QError) {
+        UNIT_ASSERT_DOUBLES_EQUAL(TEqWidthHistogramEstimatorCounters::GetQError(10, 10), 1.0, 1e-9);
+        UNIT_ASSERT_DOUBLES_EQUAL(TEqWidthHistogramEstimatorCounters::GetQError(10, 40), 4.0, 1e-9);
+        UNIT_ASSERT_DOUBLES_EQUAL(TEqWidthHistogramEstimatorCounters::GetQError(40, 10), 4.0, 1e-9);
+        // Zeros are taken as ones.
+        UNIT_ASSERT_DOUBLES_EQUAL(TEqWidthHistogramEstimatorCounters::GetQError(0, 5), 5.0, 1e-9);
+        UNIT_ASSERT_DOUBLES_EQUAL(TEqWidthHistogramEstimatorCounters::GetQError(0, 0), 1.0, 1e-9);
+    }
+
+    Y_UNIT_TEST(Lookups) {
+        auto counters = MakeIntrusive<::NMonitoring::TDynamicCounters>();
+        TEqWidthHistogramEstimatorCounters estimatorCounters(counters);
+        TEqWidthHistogramEstimator::TSettings settings;
+        settings.Counters = &estimatorCounters;
+        const TEqWidthHistogramEstimator estimator(MakeHistogram(), settings);
+        // Estimates are the same as without counters.
+        const TEqWidthHistogramEstimator plain(MakeHistogram());
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateLessOrEqual<i32>(42), plain.EstimateLessOrEqual<i32>(42));
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateEqual<i32>(42), plain.EstimateEqual<i32>(42));
+        estimator.EstimateRange<i32>(10, 20);
+        estimator.EstimateGreaterWithBounds<i32>(50);
+        const auto lookups = counters->GetCounter("EstimateLookups", true);
+        UNIT_ASSERT_VALUES_EQUAL(lookups->Val(), 4);
+
+        // A batch is counted per value.
+        const TVector<i32> values = {1, 5, 50, 99, 200};
+        TVector<ui64> result(values.size());
+        estimator.EstimateLessOrEqualBatch<i32>(values, result);
+        UNIT_ASSERT_VALUES_EQUAL(lookups->Val(), 9);
+    }
+
+    Y_UNIT_TEST(Feedback) {
+        auto counters = MakeIntrusive<::NMonitoring::TDynamicCounters>();
+        TEqWidthHistogramEstimatorCounters estimatorCounters(counters);
+        estimatorCounters.OnFeedback(10, 10);
+        estimatorCounters.OnFeedback(10, 40);
+        estimatorCounters.OnFeedback(80, 10);
+        estimatorCounters.OnFeedback(0, 0);
+        estimatorCounters.OnFeedback(1, 100000);
+        UNIT_ASSERT_VALUES_EQUAL(counters->GetCounter("EstimateFeedbacks", true)->Val(), 5);
+        UNIT_ASSERT_VALUES_EQUAL(counters->GetCounter("EstimateUnderestimates", true)->Val(), 2);
+        UNIT_ASSERT_VALUES_EQUAL(counters->GetCounter("EstimateOverestimates", true)->Val(), 1);
+        UNIT_ASSERT_VALUES_EQUAL(counters->GetCounter("EstimateLookups", true)->Val(), 0);
+
+        // Q-errors 1, 4, 8 and 1 fall into the buckets with bounds 1, 4 and 8, 10^5 into the last one.
+        const auto snapshot = counters->GetHistogram("EstimateQError", ::NMonitoring::ExponentialHistogram(16, 2, 1))->Snapshot();
+        UNIT_ASSERT_VALUES_EQUAL(snapshot->Count(), 16);
+        TVector<ui64> expected(16);
+        expected[0] = 2;
+        expected[2] = 1;
+        expected[3] = 1;
+        expected[15] = 1;
+        for (ui32 i = 0; i < snapshot->Count(); ++i) {
+            UNIT_ASSERT_VALUES_EQUAL(static_cast<ui64>(snapshot->Value(i)), expected[i]);
+        }
+    }
+}
+
+} // namespace NKikimr
@@ -0,0 +1,104 @@
+#include "eq_depth_histogram.h"
+
+namespace NKikimr {
+
+TEqDepthHistogram::TEqDepthHistogram(EHistogramValueType type)
+    : ValueType_(type)
+{
+}
+
+// Binary layout:
+// [4 byte: zero marker][1 byte: version][1 byte: value type][1 byte: flags][4 byte: number of buckets]
+// [value size: end][value size * n: starts]
+// [varint counts[0]... varint counts[n]][varint distinct[0]... varint distinct[n]].
+TEqDepthHistogram::TEqDepthHistogram(const char* str, ui64 size) {
+    const char* end = str + size;
+    const char* in = str;
+    const auto read = [&](void* data, ui64 partSize) {
+        Y_ENSURE(partSize <= static_cast<ui64>(end - in), "Truncated histogram");
+        if (partSize) {
+            std::memcpy(data, in, partSize);
+        }
+        in += partSize;
+    };
+    ui32 marker = 1;
+    ui8 version = 0;
+    ui8 flags = 0;
+    ui32 numBuckets = 0;
+    read(&marker, sizeof(ui32));
+    Y_ENSURE(marker == HistogramVersionedFormatMarker, "Histogram is not in a versioned format");
+    read(&version, sizeof(ui8));
+    Y_ENSURE(version == static_cast<ui8>(EHistogramFormat::EqDepthV1), "Unknown histogram format " << static_cast<ui32>(version));
+    read(&ValueType_, sizeof(EHistogramValueType));
+    Y_ENSURE(IsValidHistogramValueType(ValueType_), "Unknown histogram value type " << static_cast<ui32>(ValueType_));
+    read(&flags, sizeof(ui8));
+    read(&numBuckets, sizeof(ui32));
+    const ui32 valueSize = GetHistogramValueTypeSize(ValueType_);
+    // Check before allocating.
+    Y_ENSURE(numBuckets <= static_cast<ui64>(end - in) / (valueSize + 2), "Malformed number of histogram buckets");
+    AllocateBuckets(numBuckets);
+    read(End_, valueSize);
+    read(StartsStorage_.data(), static_cast<ui64>(valueSize) * numBuckets);
+    for (ui32 i = 0; i < numBuckets; ++i) {
+        in = NPrivate::ReadVarint(in, end, Counts_[i]);
+    }
+    for (ui32 i = 0; i < numBuckets; ++i) {
+        in = NPrivate::ReadVarint(in, end, Distinct_[i]);
+    }
+    Y_ENSURE(in == end, "Trailing data after histogram");
+}
+
+void TEqDepthHistogram::AllocateBuckets(ui32 numBuckets) {
+    const ui64 startsSize = static_cast<ui64>(numBuckets) * GetHistogramValueTypeSize(ValueType_);
+    Counts_ = TVector<ui64>(numBuckets);
+    Distinct_ = TVector<ui64>(numBuckets);
+    StartsStorage_ = TVector<ui64>((startsSize + sizeof(ui64) - 1) / sizeof(ui64));
+}
+
+template <typename TWrite>
+void TEqDepthHistogram::Serialize(TWrite&& write) const {
+    const ui8 version = static_cast<ui8>(EHistogramFormat::EqDepthV1);
+    const ui8 flags = 0;
+    const ui32 numBuckets = GetNumBuckets();
+    write(&HistogramVersionedFormatMarker, sizeof(ui32));
+    write(&version, sizeof(ui8));
+    write(&ValueType_, sizeof(EHistogramValueType));
+    write(&flags, sizeof(ui8));
+    write(&numBuckets, sizeof(ui32));
+    const ui32 valueSize = GetHistogramValueTypeSize(ValueType_);
+    write(End_, valueSize);
+    write(StartsStorage_.data(), static_cast<ui64>(valueSize) * numBuckets);
+    char varint[10];
+    for (const auto* counts : {&Counts_, &Distinct_}) {
+        for (const auto count : *counts) {
+            write(varint, NPrivate::WriteVarint(count, varint) - varint);
+        }
+    }
+}
+
+void TEqDepthHistogram::SerializeTo(IOutputStream& output) const {
+    Serialize([&output](const void* data, ui64 partSize) {
+        output.Write(data, partSize);
+    });
+}
+
+ui64 TEqDepthHistogram::GetSerializedSize() const {
+    ui64 size = 0;
+    Serialize([&size](const void*, ui64 partSize) {
+        size += partSize;
+    });
+    return size;
+}
+
+TEqDepthHistogramEstimator::TEqDepthHistogramEstimator(std::shared_ptr<TEqDepthHistogram> histogram)
+    : Histogram_(histogram)
+    , PrefixSum_(histogram->GetNumBuckets())
+{
+    ui64 sum = 0;
+    for (ui32 i = 0; i < Histogram_->GetNumBuckets(); ++i) {
+        sum += Histogram_->GetNumElementsInBucket(i);
+        PrefixSum_[i] = sum;
+    }
+}
+
+} // namespace NKikimr
@@ -0,0 +1,258 @@
+#pragma once
+
+#include "eq_width_histogram.h"
+
+namespace NKikimr {
+
+// This class represents an `Equi-depth` histogram.
+// Each bucket represents a range of contiguous values holding roughly the same number of rows,
+// so the boundaries follow the distribution of values and skewed columns do not end up with
+// mostly empty buckets. A bucket `i` holds values in [start[i], start[i + 1]), the last bucket holds
+// values in [start[n - 1], end]. Equal values never span several buckets. Every bucket also stores
+// the number of distinct values in it.
+class TEqDepthHistogram {
+public:
+    TEqDepthHistogram(EHistogramValueType type = EHistogramValueType::Int32);
+    // From serialized data in the `EHistogramFormat::EqDepthV1` format, throws `yexception` if the
+    // data is malformed.
+    TEqDepthHistogram(const char* str, ui64 size);
+    // From the given bucket `starts`, the last value `end`, `counts` and `distinct` counts of buckets.
+    template <typename T>
+    TEqDepthHistogram(EHistogramValueType type, TArrayRef<const T> starts, T end, TArrayRef<const ui64> counts,
+                      TArrayRef<const ui64> distinct)
+        : ValueType_(type)
+    {
+        Y_ABORT_UNLESS(sizeof(T) == GetHistogramValueTypeSize(type));
+        Y_ABORT_UNLESS(starts.size() == counts.size() && starts.size() == distinct.size() && !starts.empty());
+        AllocateBuckets(starts.size());
+        std::copy(starts.begin(), starts.end(), StartsData<T>());
+        StoreTo<T>(End_, end);
+        std::copy(counts.begin(), counts.end(), Counts_.begin());
+        std::copy(distinct.begin(), distinct.end(), Distinct_.begin());
+    }
+
+    // Builds a histogram with at most `numBuckets` buckets from the given sorted `values`.
+    // If `values` is a sample of `numRows` rows, counts are scaled to `numRows`.
+    template <typename T>
+    static TEqDepthHistogram FromSorted(TArrayRef<const T> values, ui32 numBuckets, ui64 numRows = 0,
+                                        EHistogramValueType type = GetHistogramValueType<T>()) {
+        const double scale = numRows && !values.empty() ? static_cast<double>(numRows) / values.size() : 1.0;
+        return FromSortedWeighted<T>(values, {}, numBuckets, scale, type);
+    }
+
+    // Builds a histogram with at most `numBuckets` buckets from the given sorted `values`, where
+    // every value stands for `weights[i]` rows, or for one row if `weights` is empty. Counts are
+    // multiplied by `scale`.
+    template <typename T>
+    static TEqDepthHistogram FromSortedWeighted(TArrayRef<const T> values, TArrayRef<const ui64> weights,
+                                                ui32 numBuckets, double scale = 1.0,
+                                                EHistogramValueType type = GetHistogramValueType<T>()) {
+        Y_ABORT_UNLESS(numBuckets >= 1);
+        Y_ABORT_UNLESS(weights.empty() || weights.size() == values.size());
+        if (values.empty()) {
+            return TEqDepthHistogram(type);
+        }
+        TVector<ui64> prefixWeights;
+        if (!weights.empty()) {
+            prefixWeights.resize(values.size() + 1);
+            for (size_t i = 0; i < values.size(); ++i) {
+                prefixWeights[i + 1] = prefixWeights[i] + weights[i];
+            }
+        }
+        // Returns the total weight of values in [from, to).
+        const auto weightOf = [&prefixWeights](size_t from, size_t to) -> double {
+            return prefixWeights.empty() ? to - from : prefixWeights[to] - prefixWeights[from];
+        };
+
+        TVector<T> starts;
+        TVector<ui64> counts;
+        TVector<ui64> distinct;
+        const auto addBucket = [&](size_t from, size_t to) {
+            ui64 numDistinct = 1;
+            for (size_t i = from + 1; i < to; ++i) {
+                numDistinct += CmpEqual<T>(values[i - 1], values[i]) ? 0 : 1;
+            }
+            starts.push_back(values[from]);
+            counts.push_back(static_cast<ui64>(std::llround(weightOf(from, to) * scale)));
+            distinct.push_back(numDistinct);
+        };
+        // Walks runs of equal values, a bucket is closed once it reaches the target depth. The depth
+        // is recomputed for the rest of the values every time, so heavy values do not make the later
+        // buckets too shallow. A run of a heavy value gets its own bucket.
+        size_t from = 0;
+        size_t i = 0;
+        while (i < values.size() && starts.size() + 1 < numBuckets) {
+            size_t runEnd = i + 1;
+            while (runEnd < values.size() && CmpEqual<T>(values[i], values[runEnd])) {
+                ++runEnd;
+            }
+            const double depth = weightOf(from, values.size()) / (numBuckets - starts.size());
+            if (i > from && weightOf(i, runEnd) >= depth) {
+                addBucket(from, i);
+                from = i;
+                continue;
+            }
+            i = runEnd;
+            if (weightOf(from, i) >= depth) {
+                addBucket(from, i);
+                from = i;
+            }
+        }
+        if (from < values.size()) {
+            addBucket(from, values.size());
+        }
+        return TEqDepthHistogram(type, TArrayRef<const T>(starts.data(), starts.size()), values.back(),
+                                 TArrayRef<const ui64>(counts.data(), counts.size()),
+                                 TArrayRef<const ui64>(distinct.data(), distinct.size()));
+    }
+
+    // Returns an index of the bucket which contains the given `val`, values below the first start
+    // map to the first bucket.
+    template <typename T>
+    ui32 FindBucketIndex(T val) const {
+        const T* starts = StartsData<T>();
+        const ui32 index = std::upper_bound(starts, starts + GetNumBuckets(), val, CmpLess<T>) - starts;
+        return index ? index - 1 : 0;
+    }
+
+    ui32 GetNumBuckets() const {
+        return Counts_.size();
+    }
+    EHistogramValueType GetType() const {
+        return ValueType_;
+    }
+    ui64 GetNumElementsInBucket(ui32 index) const {
+        return Counts_[index];
+    }
+    ui64 GetNumDistinctInBucket(ui32 index) const {
+        return Distinct_[index];
+    }
+    template <typename T>
+    T GetBucketStart(ui32 index) const {
+        return StartsData<T>()[index];
+    }
+    // Returns the greatest value in a histogram.
+    template <typename T>
+    T GetEnd() const {
+        return LoadFrom<T>(End_);
+    }
+    // Returns true if a histogram has no values.
+    bool Empty() const {
+        return Counts_.empty();
+    }
+
+    // Serializes to the given `output` in the `EHistogramFormat::EqDepthV1` format.
+    void SerializeTo(IOutputStream& output) const;
+    // Returns a size of the binary representation.
+    ui64 GetSerializedSize() const;
+
+private:
+    template <typename T>
+    const T* StartsData() const {
+        Y_ASSERT(sizeof(T) == GetHistogramValueTypeSize(ValueType_));
+        return reinterpret_cast<const T*>(StartsStorage_.data());
+    }
+    template <typename T>
+    T* StartsData() {
+        Y_ASSERT(sizeof(T) == GetHistogramValueTypeSize(ValueType_));
+        return reinterpret_cast<T*>(StartsStorage_.data());
+    }
+    void AllocateBuckets(ui32 numBuckets);
+    template <typename TWrite>
+    void Serialize(TWrite&& write) const;
+
+    EHistogramValueType ValueType_;
+    TVector<ui64> Counts_;
+    TVector<ui64> Distinct_;
+    TVector<ui64> StartsStorage_;
+    ui8 End_[EqWidthHistogramBucketStorageSize]{};
+};
+
+// This class represents a machinery to estimate a value in an `Equi-depth` histogram, it has the
+// same interface as `TEqWidthHistogramEstimator`. Values are assumed to be uniformly distributed
+// over the distinct values of a bucket.
+class TEqDepthHistogramEstimator {
+public:
+    TEqDepthHistogramEstimator(std::shared_ptr<TEqDepthHistogram> histogram);
+
+    template <typename T>
+    ui64 EstimateLessOrEqual(T val) const {
+        return Round(EstimateLessImpl<T>(val, true));
+    }
+
+    template <typename T>
+    ui64 EstimateGreaterOrEqual(T val) const {
+        return Round(GetNumElements() - EstimateLessImpl<T>(val, false));
+    }
+
+    template <typename T>
+    ui64 EstimateLess(T val) const {
+        return Round(EstimateLessImpl<T>(val, false));
+    }
+
+    template <typename T>
+    ui64 EstimateGreater(T val) const {
+        return Round(GetNumElements() - EstimateLessImpl<T>(val, true));
+    }
+
+    template <typename T>
+    ui64 EstimateEqual(T val) const {
+        if (Histogram_->Empty()) {
+            return 1;
+        }
+        const auto index = Histogram_->FindBucketIndex(val);
+        return std::max<ui64>(1, Histogram_->GetNumElementsInBucket(index) / std::max<ui64>(1, Histogram_->GetNumDistinctInBucket(index)));
+    }
+
+    // Returns a number of elements in the range [lo, hi].
+    template <typename T>
+    ui64 EstimateRange(T lo, T hi) const {
+        if (CmpLess<T>(hi, lo)) {
+            return 0;
+        }
+        return Round(std::max(0.0, EstimateLessImpl<T>(hi, true) - EstimateLessImpl<T>(lo, false)));
+    }
+
+    // Returns the total number elements in histogram.
+    ui64 GetNumElements() const {
+        return PrefixSum_.empty() ? 0 : PrefixSum_.back();
+    }
+
+private:
+    template <typename T>
+    double EstimateLessImpl(T val, bool orEqual) const {
+        if (Histogram_->Empty() || CmpLess<T>(val, Histogram_->template GetBucketStart<T>(0))) {
+            return 0;
+        }
+        const T end = Histogram_->template GetEnd<T>();
+        if (CmpLess<T>(end, val)) {
+            return GetNumElements();
+        }
+        const auto index = Histogram_->FindBucketIndex(val);
+        const T start = Histogram_->template GetBucketStart<T>(index);
+        const double before = index ? static_cast<double>(PrefixSum_[index - 1]) : 0.0;
+        const double count = static_cast<double>(Histogram_->GetNumElementsInBucket(index));
+        const bool last = index + 1 == Histogram_->GetNumBuckets();
+        const T next = last ? end : Histogram_->template GetBucketStart<T>(index + 1);
+        double length = static_cast<double>(NPrivate::ValueDiff<T>(next, start));
+        double offset = static_cast<double>(NPrivate::ValueDiff<T>(val, start));
+        if constexpr (!std::is_floating_point_v<T>) {
+            // The end of the last bucket is inclusive.
+            length += last ? 1 : 0;
+            offset += orEqual ? 1 : 0;
+        }
+        if (Histogram_->GetNumDistinctInBucket(index) <= 1 || length <= 0) {
+            // The bucket holds a single value equal to its start.
+            return (orEqual || CmpLess<T>(start, val)) ? before + count : before;
+        }
+        return before + count * std::min(1.0, offset / length);
+    }
+    static ui64 Round(double value) {
+        return static_cast<ui64>(std::max(0.0, value) + 0.5);
+    }
+
+    std::shared_ptr<TEqDepthHistogram> Histogram_;
+    TVector<ui64> PrefixSum_;
+};
+
+} // namespace NKikimr
@@ -2,62 +2,419 @@
 
 namespace NKikimr {
 
-TEqWidthHistogram::TEqWidthHistogram(ui32 numBuckets, EHistogramValueType valueType)
+namespace NPrivate {
+
+char* WriteVarint(ui64 value, char* out) {
+    while (value >= 0x80) {
+        *out++ = static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    *out++ = static_cast<char>(value);
+    return out;
+}
+
+const char* ReadVarint(const char* in, const char* end, ui64& value) {
+    value = 0;
+    for (ui32 shift = 0; shift < 64; shift += 7) {
+        Y_ENSURE(in < end, "Truncated varint in histogram");
+        const ui8 byte = static_cast<ui8>(*in++);
+        // Only the highest bit of the value is left for the last byte.
+        Y_ENSURE(shift < 63 || byte <= 1, "Overflowed varint in histogram");
+        value |= static_cast<ui64>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return in;
+        }
+    }
+    ythrow yexception() << "Malformed varint in histogram";
+}
+
+void ProjectCounts(TArrayRef<const double> from, TArrayRef<const ui64> counts, TArrayRef<const double> to, TArrayRef<ui64> result) {
+    Y_ABORT_UNLESS(from.size() == counts.size() + 1 && to.size() == result.size() + 1 && !result.empty());
+    ui64 total = 0;
+    for (const auto count : counts) {
+        total += count;
+    }
+    // Walks the `from` buckets once, `passed` is the total count of the buckets before `i`.
+    ui32 i = 0;
+    ui64 passed = 0;
+    auto cumulative = [&](double x) {
+        while (i < counts.size() && from[i + 1] <= x) {
+            passed += counts[i];
+            ++i;
+        }
+        if (i == counts.size() || x <= from[i]) {
+            return static_cast<double>(passed);
+        }
+        return passed + counts[i] * (x - from[i]) / (from[i + 1] - from[i]);
+    };
+    ui64 prev = 0;
+    for (ui32 j = 0; j + 1 < result.size(); ++j) {
+        const ui64 next = std::min(total, static_cast<ui64>(cumulative(to[j + 1]) + 0.5));
+        result[j] = next - prev;
+        prev = next;
+    }
+    result.back() = total - prev;
+}
+
+} // namespace NPrivate
+
+TEqWidthHistogram::TEqWidthHistogram(ui32 numBuckets, EHistogramValueType valueType, std::pmr::memory_resource* resource)
     : ValueType_(valueType)
-    , Buckets_(numBuckets)
+    , Counts_(resource)
+    , StartsStorage_(resource)
 {
     // Exptected at least one bucket for histogram.
     Y_ASSERT(numBuckets >= 1);
+    AllocateBuckets(numBuckets);
 }
 
-TEqWidthHistogram::TEqWidthHistogram(const char* str, ui64 size) {
-    Y_ASSERT(str && size);
-    const ui32 numBuckets = *reinterpret_cast<const ui32*>(str);
-    Y_ABORT_UNLESS(GetBinarySize(numBuckets) == size);
+TEqWidthHistogram::TEqWidthHistogram(const char* str, ui64 size, std::pmr::memory_resource* resource)
+    : Counts_(resource)
+    , StartsStorage_(resource)
+{
+    Y_ASSERT(str);
+    Y_ENSURE(size >= sizeof(ui32), "Truncated histogram");
+    const ui32 numBuckets = LoadFrom<ui32>(reinterpret_cast<const ui8*>(str));
+    if (numBuckets == HistogramVersionedFormatMarker) {
+        DeserializeV2(str, size);
+        return;
+    }
+    Y_ENSURE(GetBinarySize(numBuckets) == size, "Histogram size does not match the number of buckets");
     ui32 offset = sizeof(ui32);
     ValueType_ = *reinterpret_cast<const EHistogramValueType*>(str + offset);
+    Y_ENSURE(IsValidHistogramValueType(ValueType_), "Unknown histogram value type " << static_cast<ui32>(ValueType_));
     offset += sizeof(EHistogramValueType);
-    Buckets_ = TVector<TBucket>(numBuckets);
+    AllocateBuckets(numBuckets);
+    const ui32 valueSize = GetHistogramValueTypeSize(ValueType_);
     for (ui32 i = 0; i < numBuckets; ++i) {
-        std::memcpy(&Buckets_[i], reinterpret_cast<const char*>(str + offset), sizeof(TBucket));
+        std::memcpy(&Counts_[i], str + offset + offsetof(TBucket, Count), sizeof(ui64));
+        std::memcpy(GetStartBytes(i), str + offset + offsetof(TBucket, Start), valueSize);
         offset += sizeof(TBucket);
     }
+    UpdateEqWidthLayout();
+}
+
+void TEqWidthHistogram::AllocateBuckets(ui32 numBuckets) {
+    const ui64 startsSize = static_cast<ui64>(numBuckets) * GetHistogramValueTypeSize(ValueType_);
+    // Keep the memory resource of the arrays.
+    Counts_.assign(numBuckets, 0);
+    StartsStorage_.assign((startsSize + sizeof(ui64) - 1) / sizeof(ui64), 0);
+}
+
+void TEqWidthHistogram::UpdateEqWidthLayout() {
+    if (ValueType_ == EHistogramValueType::NotSupported) {
+        EqWidthLayout_ = false;
+        return;
+    }
+    VisitHistogramValueType(ValueType_, [this](auto tag) {
+        UpdateEqWidthLayout<typename decltype(tag)::type>();
+    });
 }
 
 ui64 TEqWidthHistogram::GetBinarySize(ui32 nBuckets) const {
     return sizeof(ui32) + sizeof(EHistogramValueType) + sizeof(TBucket) * nBuckets;
 }
 
-// Binary layout:
+// Binary layout V1:
 // [4 byte: number of buckets][1 byte: value type]
 // [sizeof(Bucket)[0]... sizeof(Bucket)[n]].
-std::unique_ptr<char> TEqWidthHistogram::Serialize(ui64& binarySize) const {
-    binarySize = GetBinarySize(GetNumBuckets());
-    std::unique_ptr<char> binaryData(new char[binarySize]);
+//
+// Binary layout V2:
+// [4 byte: zero marker][1 byte: version][1 byte: value type][1 byte: flags][4 byte: number of buckets]
+// [value size: first start][8 byte: width] if `EqWidthLayoutFlag` is set,
+// [value size * n: starts] otherwise,
+// [varint counts[0]... varint counts[n]],
+// [HyperLogLog sketch] if `NdvFlag` is set, [HyperLogLog sketch * n] if `BucketNdvFlag` is set.
+std::unique_ptr<char[]> TEqWidthHistogram::Serialize(ui64& binarySize, EHistogramFormat format) const {
+    binarySize = GetSerializedSize(format);
+    std::unique_ptr<char[]> binaryData(new char[binarySize]);
+    SerializeTo(TArrayRef<char>(binaryData.get(), binarySize), format);
+    return binaryData;
+}
+
+ui64 TEqWidthHistogram::GetAllocatedSize() const {
+    ui64 size = sizeof(*this) + (Counts_.capacity() + StartsStorage_.capacity()) * sizeof(ui64);
+    // Sketches are dominated by their registers.
+    if (Ndv_) {
+        size += Ndv_->GetSerializedSize();
+    }
+    for (const auto& ndv : BucketNdv_) {
+        size += sizeof(ndv) + ndv.GetSerializedSize();
+    }
+    return size;
+}
+
+ui64 TEqWidthHistogram::GetSerializedSize(EHistogramFormat format) const {
+    Y_ABORT_UNLESS(format == EHistogramFormat::V1 || format == EHistogramFormat::V2);
+    if (format == EHistogramFormat::V1) {
+        return GetBinarySize(GetNumBuckets());
+    }
+    ui64 size = 0;
+    SerializeV2([&size](const void*, ui64 partSize) {
+        size += partSize;
+    });
+    return size;
+}
+
+ui64 TEqWidthHistogram::SerializeTo(TArrayRef<char> buffer, EHistogramFormat format) const {
+    Y_ABORT_UNLESS(format == EHistogramFormat::V1 || format == EHistogramFormat::V2);
+    if (format == EHistogramFormat::V2) {
+        ui64 offset = 0;
+        SerializeV2([&](const void* data, ui64 partSize) {
+            Y_ABORT_UNLESS(offset + partSize <= buffer.size());
+            std::memcpy(buffer.data() + offset, data, partSize);
+            offset += partSize;
+        });
+        return offset;
+    }
+    const ui64 binarySize = GetSerializedSize();
+    Y_ABORT_UNLESS(buffer.size() >= binarySize);
+    char* binaryData = buffer.data();
     ui32 offset = 0;
     const ui32 numBuckets = GetNumBuckets();
     // 4 byte - number of buckets.
-    std::memcpy(binaryData.get(), &numBuckets, sizeof(ui32));
+    std::memcpy(binaryData, &numBuckets, sizeof(ui32));
     offset += sizeof(ui32);
     // 1 byte - values type.
-    std::memcpy(binaryData.get() + offset, &ValueType_, sizeof(EHistogramValueType));
+    std::memcpy(binaryData + offset, &ValueType_, sizeof(EHistogramValueType));
     offset += sizeof(EHistogramValueType);
     // Buckets.
+    SerializeBucketsTo(0, numBuckets, binaryData + offset);
+    return binarySize;
+}
+
+void TEqWidthHistogram::SerializeTo(IOutputStream& output, EHistogramFormat format) const {
+    Y_ABORT_UNLESS(format == EHistogramFormat::V1 || format == EHistogramFormat::V2);
+    if (format == EHistogramFormat::V2) {
+        SerializeV2([&output](const void* data, ui64 partSize) {
+            output.Write(data, partSize);
+        });
+        return;
+    }
+    const ui32 numBuckets = GetNumBuckets();
+    output.Write(&numBuckets, sizeof(ui32));
+    output.Write(&ValueType_, sizeof(EHistogramValueType));
+    // Buckets are written by chunks to keep the number of writes low.
+    constexpr ui32 chunkSize = 256;
+    char chunk[chunkSize * sizeof(TBucket)];
+    for (ui32 i = 0; i < numBuckets; i += chunkSize) {
+        const ui32 to = std::min(numBuckets, i + chunkSize);
+        SerializeBucketsTo(i, to, chunk);
+        output.Write(chunk, (to - i) * sizeof(TBucket));
+    }
+}
+
+template <typename TWrite>
+void TEqWidthHistogram::SerializeV2(TWrite&& write) const {
+    const ui32 numBuckets = GetNumBuckets();
+    const ui8 version = static_cast<ui8>(EHistogramFormat::V2);
+    const bool compactLayout = IsCompactLayout();
+    const ui8 flags = (compactLayout ? NPrivate::EqWidthLayoutFlag : 0) | (Ndv_ ? NPrivate::NdvFlag : 0) | (BucketNdv_.empty() ? 0 : NPrivate::BucketNdvFlag);
+    write(&HistogramVersionedFormatMarker, sizeof(ui32));
+    write(&version, sizeof(ui8));
+    write(&ValueType_, sizeof(EHistogramValueType));
+    write(&flags, sizeof(ui8));
+    write(&numBuckets, sizeof(ui32));
+    const ui32 valueSize = GetHistogramValueTypeSize(ValueType_);
+    if (compactLayout) {
+        write(GetStartBytes(0), valueSize);
+        write(LayoutWidth_, sizeof(LayoutWidth_));
+    } else {
+        write(GetStartBytes(0), static_cast<ui64>(valueSize) * numBuckets);
+    }
+    // Counts are encoded by chunks to keep the number of writes low.
+    constexpr ui32 chunkSize = 256;
+    char chunk[chunkSize * 10];
+    for (ui32 i = 0; i < numBuckets; i += chunkSize) {
+        const ui32 to = std::min(numBuckets, i + chunkSize);
+        char* out = chunk;
+        for (ui32 j = i; j < to; ++j) {
+            out = NPrivate::WriteVarint(Counts_[j], out);
+        }
+        write(chunk, out - chunk);
+    }
+    if (Ndv_) {
+        Ndv_->SerializeTo(write);
+    }
+    for (const auto& ndv : BucketNdv_) {
+        ndv.SerializeTo(write);
+    }
+}
+
+void TEqWidthHistogram::DeserializeV2(const char* str, ui64 size) {
+    const char* end = str + size;
+    const char* in = str + sizeof(ui32);
+    const auto read = [&](void* data, ui64 partSize) {
+        Y_ENSURE(partSize <= static_cast<ui64>(end - in), "Truncated histogram");
+        std::memcpy(data, in, partSize);
+        in += partSize;
+    };
+    ui8 version = 0;
+    ui8 flags = 0;
+    ui32 numBuckets = 0;
+    read(&version, sizeof(ui8));
+    Y_ENSURE(version == static_cast<ui8>(EHistogramFormat::V2), "Unknown histogram format " << static_cast<ui32>(version));
+    read(&ValueType_, sizeof(EHistogramValueType));
+    Y_ENSURE(IsValidHistogramValueType(ValueType_), "Unknown histogram value type " << static_cast<ui32>(ValueType_));
+    read(&flags, sizeof(ui8));
+    read(&numBuckets, sizeof(ui32));
+    const ui32 valueSize = GetHistogramValueTypeSize(ValueType_);
+    // Every bucket takes at least a byte of its count, check before allocating.
+    Y_ENSURE(numBuckets >= 1 && numBuckets <= static_cast<ui64>(end - in), "Malformed number of histogram buckets");
+    AllocateBuckets(numBuckets);
+    if (flags & NPrivate::EqWidthLayoutFlag) {
+        Y_ENSURE(ValueType_ != EHistogramValueType::NotSupported, "Equal-width layout of unsupported values");
+        read(GetStartBytes(0), valueSize);
+        ui8 width[EqWidthHistogramBucketStorageSize];
+        read(width, sizeof(width));
+        VisitHistogramValueType(ValueType_, [&](auto tag) {
+            using T = typename decltype(tag)::type;
+            const auto bucketWidth = LoadFrom<NPrivate::TBucketWidth<T>>(width);
+            T* starts = StartsData<T>();
+            for (ui32 i = 1; i < numBuckets; ++i) {
+                starts[i] = NPrivate::NextStart<T>(starts[i - 1], bucketWidth);
+            }
+        });
+    } else {
+        read(GetStartBytes(0), static_cast<ui64>(valueSize) * numBuckets);
+    }
     for (ui32 i = 0; i < numBuckets; ++i) {
-        std::memcpy(binaryData.get() + offset, &Buckets_[i], sizeof(TBucket));
-        offset += sizeof(TBucket);
+        in = NPrivate::ReadVarint(in, end, Counts_[i]);
+    }
+    Ndv_.reset();
+    BucketNdv_.clear();
+    if (flags & NPrivate::NdvFlag) {
+        in = Ndv_.emplace().Deserialize(in, end);
+    }
+    if (flags & NPrivate::BucketNdvFlag) {
+        Y_ENSURE(Ndv_, "Bucket distinct counts without the histogram one");
+        BucketNdv_.reserve(numBuckets);
+        for (ui32 i = 0; i < numBuckets; ++i) {
+            THyperLogLogSketch ndv(THyperLogLogSketch::MinPrecision);
+            in = ndv.Deserialize(in, end);
+            BucketNdv_.push_back(std::move(ndv));
+        }
+    }
+    Y_ENSURE(in == end, "Trailing data after histogram");
+    UpdateEqWidthLayout();
+}
+
+bool TEqWidthHistogram::IsCompactLayout() const {
+    if (!EqWidthLayout_) {
+        return false;
+    }
+    return VisitHistogramValueType(ValueType_, [this](auto tag) {
+        using T = typename decltype(tag)::type;
+        const auto layout = GetEqWidthLayout<T>();
+        const T* starts = StartsData<T>();
+        T start = starts[0];
+        for (ui32 i = 1; i < GetNumBuckets(); ++i) {
+            start = NPrivate::NextStart<T>(start, layout.Width);
+            if (std::memcmp(&start, &starts[i], sizeof(T))) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+void TEqWidthHistogram::FoldBucketNdv(bool down) {
+    if (BucketNdv_.empty()) {
+        return;
+    }
+    const ui32 n = BucketNdv_.size();
+    TVector<THyperLogLogSketch> folded(n, THyperLogLogSketch(BucketNdv_.front().GetPrecision()));
+    for (ui32 i = 0; i < n; ++i) {
+        folded[down ? (n + i) / 2 : i / 2].Merge(BucketNdv_[i]);
+    }
+    BucketNdv_ = std::move(folded);
+}
+
+void TEqWidthHistogram::MergeNdv(const TEqWidthHistogram& other, bool sameBuckets) {
+    if (Ndv_ && !(other.Ndv_ && Ndv_->Merge(*other.Ndv_))) {
+        Ndv_.reset();
+        BucketNdv_.clear();
+        return;
+    }
+    if (BucketNdv_.empty()) {
+        return;
+    }
+    if (!sameBuckets || other.BucketNdv_.size() != BucketNdv_.size()) {
+        BucketNdv_.clear();
+        return;
+    }
+    for (ui32 i = 0; i < BucketNdv_.size(); ++i) {
+        if (!BucketNdv_[i].Merge(other.BucketNdv_[i])) {
+            BucketNdv_.clear();
+            return;
+        }
+    }
+}
+
+void TEqWidthHistogram::SerializeBucketsTo(ui32 from, ui32 to, char* binaryData) const {
+    const ui32 valueSize = GetHistogramValueTypeSize(ValueType_);
+    for (ui32 i = from; i < to; ++i) {
+        TBucket bucket;
+        bucket.Count = Counts_[i];
+        std::memset(bucket.Start, 0, sizeof(bucket.Start));
+        std::memcpy(bucket.Start, GetStartBytes(i), valueSize);
+        std::memcpy(binaryData, &bucket, sizeof(TBucket));
+        binaryData += sizeof(TBucket);
     }
-    return binaryData;
 }
 
 TEqWidthHistogramEstimator::TEqWidthHistogramEstimator(std::shared_ptr<TEqWidthHistogram> histogram)
-    : Histogram_(histogram)
+    : TEqWidthHistogramEstimator(std::move(histogram), TSettings())
+{
+}
+
+TEqWidthHistogramEstimator::TEqWidthHistogramEstimator(std::shared_ptr<TEqWidthHistogram> histogram, TSettings settings)
+    : Owner_(std::move(histogram))
+    , Histogram_(Owner_.get())
+    , Settings_(settings)
 {
+    Refresh();
+}
+
+TEqWidthHistogramEstimator::TEqWidthHistogramEstimator(TEqWidthHistogram& histogram, TSettings settings, std::pmr::memory_resource* resource)
+    : Histogram_(&histogram)
+    , Settings_(settings)
+    , PrefixSum_(resource)
+    , BucketNdv_(resource)
+{
+    Refresh();
+}
+
+void TEqWidthHistogramEstimator::Refresh() {
     const auto numBuckets = Histogram_->GetNumBuckets();
-    PrefixSum_ = TVector<ui64>(numBuckets);
-    SuffixSum_ = TVector<ui64>(numBuckets);
+    PrefixSum_.assign(numBuckets, 0);
     CreatePrefixSum(numBuckets);
-    CreateSuffixSum(numBuckets);
+    NumElements_ = 0;
+    for (ui32 i = 0; i < numBuckets; ++i) {
+        NumElements_ += Histogram_->GetNumElementsInBucket(i);
+    }
+    RefreshNdv();
+}
+
+ui64 TEqWidthHistogramEstimator::GetAllocatedSize() const {
+    ui64 size = sizeof(*this) + (PrefixSum_.capacity() + BucketNdv_.capacity()) * sizeof(ui64);
+    if (Owner_) {
+        size += Owner_->GetAllocatedSize();
+    }
+    return size;
+}
+
+void TEqWidthHistogramEstimator::RefreshNdv() {
+    // No distinct values of a non empty histogram are unknown, see `EstimateEqualInBucket()`.
+    HasNdv_ = Histogram_->HasNdv() && (Histogram_->GetNdv() || !NumElements_);
+    Ndv_ = HasNdv_ ? Histogram_->GetNdv() : 0;
+    BucketNdv_.clear();
+    if (Histogram_->HasBucketNdv()) {
+        BucketNdv_.resize(Histogram_->GetNumBuckets());
+        for (ui32 i = 0; i < BucketNdv_.size(); ++i) {
+            BucketNdv_[i] = Histogram_->GetBucketNdv(i);
+        }
+    }
 }
 
 void TEqWidthHistogramEstimator::CreatePrefixSum(ui32 numBuckets) {
@@ -65,12 +422,26 @@ void TEqWidthHistogramEstimator::CreatePrefixSum(ui32 numBuckets) {
     for (ui32 i = 1; i < numBuckets; ++i) {
         PrefixSum_[i] = PrefixSum_[i - 1] + Histogram_->GetNumElementsInBucket(i);
     }
+    if (Settings_.Mode == EMode::Incremental) {
+        // Fenwick tree node `i` (1-based) holds the sum of buckets (i - lowbit(i), i].
+        for (ui32 i = numBuckets; i; --i) {
+            const ui32 from = i & (i - 1);
+            PrefixSum_[i - 1] -= from ? PrefixSum_[from - 1] : 0;
+        }
+    }
 }
 
-void TEqWidthHistogramEstimator::CreateSuffixSum(ui32 numBuckets) {
-    SuffixSum_[numBuckets - 1] = Histogram_->GetNumElementsInBucket(numBuckets - 1);
-    for (i32 i = static_cast<i32>(numBuckets) - 2; i >= 0; --i) {
-        SuffixSum_[i] = SuffixSum_[i + 1] + Histogram_->GetNumElementsInBucket(i);
+void TEqWidthHistogramEstimator::UpdateBucket(ui32 index, ui64 count) {
+    NumElements_ += count;
+    const ui32 numBuckets = PrefixSum_.size();
+    if (Settings_.Mode == EMode::Static) {
+        for (ui32 i = index; i < numBuckets; ++i) {
+            PrefixSum_[i] += count;
+        }
+        return;
+    }
+    for (ui32 i = index + 1; i <= numBuckets; i += i & (~i + 1)) {
+        PrefixSum_[i - 1] += count;
     }
 }
 } // namespace NKikimr
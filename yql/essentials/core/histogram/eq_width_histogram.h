@@ -1,10 +1,20 @@
 #pragma once
 
+#include "hyperloglog.h"
+
+#include <util/generic/array_ref.h>
 #include <util/generic/strbuf.h>
 #include <util/generic/vector.h>
+#include <util/generic/yexception.h>
 #include <util/stream/output.h>
 #include <util/system/types.h>
+#include <array>
 #include <cmath>
+#include <limits>
+#include <memory_resource>
+#include <numeric>
+#include <optional>
+#include <type_traits>
 
 namespace NKikimr {
 
@@ -27,12 +37,17 @@ template <>
 inline bool CmpEqual(double left, double right) {
     return std::fabs(left - right) < std::numeric_limits<double>::epsilon();
 }
+template <>
+inline bool CmpEqual(float left, float right) {
+    return std::fabs(left - right) < std::numeric_limits<float>::epsilon();
+}
 template <typename T>
 inline bool CmpLess(T left, T right) {
     return left < right;
 }
 
 // Represents value types supported by histogram.
+// New types are appended, so the values of the serialized types are kept.
 enum class EHistogramValueType: ui8 { Int16,
                                       Int32,
                                       Int64,
@@ -40,18 +55,503 @@ enum class EHistogramValueType: ui8 { Int16,
                                       Uint32,
                                       Uint64,
                                       Double,
-                                      NotSupported };
+                                      NotSupported,
+                                      Float,
+                                      // Days since the epoch, as `ui16`.
+                                      Date,
+                                      // Seconds since the epoch, as `ui32`.
+                                      Datetime,
+                                      // Microseconds since the epoch, as `ui64`.
+                                      Timestamp,
+                                      // Microseconds, as `i64`.
+                                      Interval,
+                                      // Decimal values approximated by `double`, see `DecimalToHistogramValue()`.
+                                      Decimal,
+                                      // String and Utf8 values represented by the prefix, as `ui64`, see
+                                      // `StringToHistogramValue()`.
+                                      String };
 
 // Bucket storage size for Equal width histogram.
 constexpr const ui32 EqWidthHistogramBucketStorageSize = 8;
 
+// Returns the size of a value of the given `type`.
+constexpr ui32 GetHistogramValueTypeSize(EHistogramValueType type) {
+    switch (type) {
+        case EHistogramValueType::Int16:
+        case EHistogramValueType::Uint16:
+        case EHistogramValueType::Date:
+            return sizeof(ui16);
+        case EHistogramValueType::Int32:
+        case EHistogramValueType::Uint32:
+        case EHistogramValueType::Float:
+        case EHistogramValueType::Datetime:
+            return sizeof(ui32);
+        case EHistogramValueType::Int64:
+        case EHistogramValueType::Uint64:
+        case EHistogramValueType::Double:
+        case EHistogramValueType::Timestamp:
+        case EHistogramValueType::Interval:
+        case EHistogramValueType::Decimal:
+        case EHistogramValueType::String:
+        case EHistogramValueType::NotSupported:
+            return EqWidthHistogramBucketStorageSize;
+    }
+    return EqWidthHistogramBucketStorageSize;
+}
+
+// Returns true if the given `type`, e.g. read from serialized data, is one of the known types.
+constexpr bool IsValidHistogramValueType(EHistogramValueType type) {
+    return static_cast<ui8>(type) <= static_cast<ui8>(EHistogramValueType::String);
+}
+
+// Calls `visitor(std::type_identity<T>{})` with the type `T` of values of the given `type`, so the
+// code generic over the value type dispatches once, e.g. per column rather than per value:
+//   VisitHistogramValueType(histogram.GetType(), [&](auto tag) {
+//       using T = typename decltype(tag)::type;
+//       histogram.AddElements<T>(...);
+//   });
+template <typename TVisitor>
+decltype(auto) VisitHistogramValueType(EHistogramValueType type, TVisitor&& visitor) {
+    switch (type) {
+        case EHistogramValueType::Int16:
+            return visitor(std::type_identity<i16>{});
+        case EHistogramValueType::Int32:
+            return visitor(std::type_identity<i32>{});
+        case EHistogramValueType::Int64:
+        case EHistogramValueType::Interval:
+            return visitor(std::type_identity<i64>{});
+        case EHistogramValueType::Uint16:
+        case EHistogramValueType::Date:
+            return visitor(std::type_identity<ui16>{});
+        case EHistogramValueType::Uint32:
+        case EHistogramValueType::Datetime:
+            return visitor(std::type_identity<ui32>{});
+        case EHistogramValueType::Uint64:
+        case EHistogramValueType::Timestamp:
+        case EHistogramValueType::String:
+            return visitor(std::type_identity<ui64>{});
+        case EHistogramValueType::Double:
+        case EHistogramValueType::Decimal:
+            return visitor(std::type_identity<double>{});
+        case EHistogramValueType::Float:
+            return visitor(std::type_identity<float>{});
+        case EHistogramValueType::NotSupported:
+            break;
+    }
+    Y_ABORT("Histogram value type is not supported");
+}
+
+// Returns the histogram value type for values of the type `T`, the types with the same
+// representation, e.g. `Date` for `ui16`, have to be specified explicitly.
+template <typename T>
+constexpr EHistogramValueType GetHistogramValueType() {
+    if constexpr (std::is_same_v<T, i16>) {
+        return EHistogramValueType::Int16;
+    } else if constexpr (std::is_same_v<T, i32>) {
+        return EHistogramValueType::Int32;
+    } else if constexpr (std::is_same_v<T, i64>) {
+        return EHistogramValueType::Int64;
+    } else if constexpr (std::is_same_v<T, ui16>) {
+        return EHistogramValueType::Uint16;
+    } else if constexpr (std::is_same_v<T, ui32>) {
+        return EHistogramValueType::Uint32;
+    } else if constexpr (std::is_same_v<T, ui64>) {
+        return EHistogramValueType::Uint64;
+    } else if constexpr (std::is_same_v<T, double>) {
+        return EHistogramValueType::Double;
+    } else if constexpr (std::is_same_v<T, float>) {
+        return EHistogramValueType::Float;
+    } else {
+        return EHistogramValueType::NotSupported;
+    }
+}
+
+// Returns the value of the `String` type for the given string: the first 8 bytes as a big-endian
+// number, padded with zeros, so values are ordered as the strings are. Strings with the same prefix
+// fall into the same bucket.
+inline ui64 StringToHistogramValue(TStringBuf str) {
+    ui64 value = 0;
+    for (size_t i = 0; i < sizeof(ui64); ++i) {
+        value = (value << 8) | (i < str.size() ? static_cast<ui8>(str[i]) : 0);
+    }
+    return value;
+}
+
+// Returns the value of the `Decimal` type for the given unscaled decimal value with the given `scale`.
+// The precision is limited by `double`, which is enough to estimate selectivities.
+inline double DecimalToHistogramValue(double unscaled, ui32 scale) {
+    return unscaled / std::pow(10.0, scale);
+}
+
+namespace NPrivate {
+
+// The type of a distance between two histogram values: integer values are measured in `ui64`
+// (so the distance between any two values of any supported integer type is representable),
+// floating point values in `double`.
+template <typename T>
+using TBucketWidth = std::conditional_t<std::is_floating_point_v<T>, double, ui64>;
+
+// Returns `left - right`, expects `right <= left`.
+template <typename T>
+inline TBucketWidth<T> ValueDiff(T left, T right) {
+    if constexpr (std::is_floating_point_v<T>) {
+        return static_cast<double>(left) - static_cast<double>(right);
+    } else {
+        // Modular arithmetic gives the exact distance for signed types as well.
+        return static_cast<ui64>(left) - static_cast<ui64>(right);
+    }
+}
+
+// Returns the start of the bucket following the bucket starting at `prev` of the given `width`.
+template <typename T>
+inline T NextStart(T prev, TBucketWidth<T> width) {
+    if constexpr (std::is_floating_point_v<T>) {
+        return prev + width;
+    } else {
+        return static_cast<T>(static_cast<ui64>(prev) + width);
+    }
+}
+
+// Describes buckets laid out with the equal width: start[i] = start[0] + i * width.
+template <typename T>
+struct TEqWidthLayout {
+    T Start{};
+    TBucketWidth<T> Width{};
+    double InvWidth{0};
+    ui32 NumBuckets{0};
+};
+
+// Checks that the given starts form an equal-width layout and fills the `layout`.
+// `getStart(i)` returns the start of the i-th bucket.
+template <typename T, typename TGetStart>
+bool DetectEqWidthLayout(ui32 numBuckets, TGetStart&& getStart, TEqWidthLayout<T>& layout) {
+    if (numBuckets < 2) {
+        return false;
+    }
+    const T start = getStart(0);
+    const T next = getStart(1);
+    if (!CmpLess<T>(start, next)) {
+        return false;
+    }
+    const auto width = ValueDiff<T>(next, start);
+    for (ui32 i = 2; i < numBuckets; ++i) {
+        const T prev = getStart(i - 1);
+        const T curr = getStart(i);
+        if (!CmpLess<T>(prev, curr)) {
+            return false;
+        }
+        if constexpr (std::is_floating_point_v<T>) {
+            // Starts of double buckets are accumulated, so allow a small drift, the exact
+            // position is corrected by the neighbour starts.
+            // `float` starts are rounded much coarser.
+            const double tolerance = std::is_same_v<T, float> ? 1e-3 : 1e-6;
+            if (std::fabs(ValueDiff<T>(curr, prev) - width) > width * tolerance) {
+                return false;
+            }
+        } else if (ValueDiff<T>(curr, prev) != width) {
+            return false;
+        }
+    }
+    layout.Start = start;
+    layout.Width = width;
+    layout.InvWidth = 1.0 / static_cast<double>(width);
+    layout.NumBuckets = numBuckets;
+    return true;
+}
+
+// Returns starts of at most `numBuckets` equal-width buckets covering [min, max]. Starts never
+// overflow `T`: for integers the width is chosen so that the last start does not exceed `max`, and
+// the number of buckets is reduced if the range has fewer values than buckets.
+template <typename T>
+TVector<T> MakeEqWidthStarts(T min, T max, ui32 numBuckets) {
+    Y_ABORT_UNLESS(numBuckets >= 1);
+    if (!CmpLess<T>(min, max)) {
+        return {min};
+    }
+    TVector<T> starts;
+    if constexpr (std::is_floating_point_v<T>) {
+        const double width = (static_cast<double>(max) - static_cast<double>(min)) / numBuckets;
+        starts.resize(numBuckets);
+        for (ui32 i = 0; i < numBuckets; ++i) {
+            starts[i] = static_cast<T>(min + width * i);
+        }
+    } else {
+        const ui64 span = ValueDiff<T>(max, min);
+        ui64 width = 1;
+        if (span < numBuckets) {
+            numBuckets = static_cast<ui32>(span + 1);
+        } else {
+            // Round the width up unless the last start would go past `max`:
+            // (numBuckets - 1) * (q + 1) <= span <=> numBuckets - 1 <= q + r.
+            const ui64 q = span / numBuckets;
+            const ui64 r = span % numBuckets;
+            width = numBuckets - 1 <= q + r ? q + 1 : q;
+        }
+        starts.resize(numBuckets);
+        for (ui32 i = 0; i < numBuckets; ++i) {
+            starts[i] = static_cast<T>(static_cast<ui64>(min) + i * width);
+        }
+    }
+    return starts;
+}
+
+// Fills the given `starts` with equal-width buckets covering [min, max], as `MakeEqWidthStarts()`
+// does. If it returns fewer buckets, the next ones continue with the unit width up to the maximum of
+// `T`. Returns the number of filled starts, which is less than `starts.size()` only if `T` has fewer
+// values from `min`, so starts never repeat.
+template <typename T>
+ui32 FillEqWidthStarts(T min, T max, TArrayRef<T> starts) {
+    Y_ABORT_UNLESS(!starts.empty());
+    const auto eqWidthStarts = MakeEqWidthStarts<T>(min, max, starts.size());
+    std::copy(eqWidthStarts.begin(), eqWidthStarts.end(), starts.begin());
+    size_t i = eqWidthStarts.size();
+    for (; i < starts.size() && CmpLess<T>(starts[i - 1], std::numeric_limits<T>::max()); ++i) {
+        starts[i] = static_cast<T>(starts[i - 1] + 1);
+    }
+    return i;
+}
+
+// Returns an index of the bucket which contains the given `val`, that is the last bucket with
+// start <= val. Values below the first start belong to the first bucket and values above the
+// last start belong to the last bucket.
+template <typename T, typename TGetStart>
+inline ui32 ContainingBucketIndex(const TEqWidthLayout<T>& layout, TGetStart&& getStart, T val) {
+    const ui32 last = layout.NumBuckets - 1;
+    if constexpr (std::is_floating_point_v<T>) {
+        // NaN goes to the first bucket, as the binary search does.
+        if (std::isnan(val)) {
+            return 0;
+        }
+        const double diff = val > layout.Start ? ValueDiff<T>(val, layout.Start) : 0.0;
+        const double q = diff * layout.InvWidth;
+        ui32 index = q < static_cast<double>(last) ? static_cast<ui32>(q) : last;
+        while (index && CmpLess<T>(val, getStart(index))) {
+            --index;
+        }
+        while (index < last && !CmpLess<T>(val, getStart(index + 1))) {
+            ++index;
+        }
+        return index;
+    } else {
+        Y_UNUSED(getStart);
+        const ui64 diff = CmpLess<T>(layout.Start, val) ? ValueDiff<T>(val, layout.Start) : 0;
+        const double q = static_cast<double>(diff) * layout.InvWidth;
+        ui64 index = q < static_cast<double>(last) ? static_cast<ui64>(q) : last;
+        // The reciprocal is off by at most one bucket, `index * width` never overflows
+        // since the start of the last bucket is representable.
+        if (index && index * layout.Width > diff) {
+            --index;
+        } else if (index < last && (index + 1) * layout.Width <= diff) {
+            ++index;
+        }
+        return static_cast<ui32>(index);
+    }
+}
+
+// Returns an index of the first bucket with start >= val, or the last bucket if there is no such one.
+// This is the index found by the binary search over the starts.
+template <typename T, typename TGetStart>
+inline ui32 LowerBoundBucketIndex(const TEqWidthLayout<T>& layout, TGetStart&& getStart, T val) {
+    const ui32 index = ContainingBucketIndex<T>(layout, getStart, val);
+    if (index + 1 == layout.NumBuckets) {
+        return index;
+    }
+    if constexpr (std::is_floating_point_v<T>) {
+        return CmpLess<T>(getStart(index), val) ? index + 1 : index;
+    } else {
+        const ui64 diff = CmpLess<T>(layout.Start, val) ? ValueDiff<T>(val, layout.Start) : 0;
+        return static_cast<ui64>(index) * layout.Width < diff ? index + 1 : index;
+    }
+}
+
+// Counts the given `values` into `counts` for the equal-width `layout`.
+// Values are processed in blocks: bucket indices of a whole block are computed first, then counted.
+// Small histograms are counted into several interleaved lanes on the stack, so the increments of
+// the same bucket by the neighbour values do not depend on each other, and lanes are merged into
+// `counts` at the end. Large histograms and batches shorter than the lanes are counted into `counts`
+// directly, since zeroing and merging the lanes would cost more than it saves.
+template <typename T, typename TGetStart>
+void CountEqWidth(const TEqWidthLayout<T>& layout, TGetStart&& getStart, TArrayRef<const T> values, ui64* counts) {
+    constexpr ui32 blockSize = 1024;
+    constexpr ui32 numLanes = 4;
+    constexpr ui32 maxLaneBuckets = 256;
+    const ui32 numBuckets = layout.NumBuckets;
+    const bool useLanes = numBuckets <= maxLaneBuckets && values.size() >= static_cast<size_t>(numLanes) * numBuckets;
+    std::array<ui64, numLanes * maxLaneBuckets> laneCounts;
+    if (useLanes) {
+        std::fill_n(laneCounts.data(), numLanes * numBuckets, 0);
+    }
+    ui32 indices[blockSize];
+    for (size_t offset = 0; offset < values.size(); offset += blockSize) {
+        const ui32 blockLen = static_cast<ui32>(std::min<size_t>(blockSize, values.size() - offset));
+        const T* block = values.data() + offset;
+        for (ui32 i = 0; i < blockLen; ++i) {
+            indices[i] = ContainingBucketIndex<T>(layout, getStart, block[i]);
+        }
+        if (useLanes) {
+            ui32 i = 0;
+            for (; i + numLanes <= blockLen; i += numLanes) {
+                ++laneCounts[indices[i]];
+                ++laneCounts[numBuckets + indices[i + 1]];
+                ++laneCounts[2 * numBuckets + indices[i + 2]];
+                ++laneCounts[3 * numBuckets + indices[i + 3]];
+            }
+            for (; i < blockLen; ++i) {
+                ++laneCounts[indices[i]];
+            }
+        } else {
+            for (ui32 i = 0; i < blockLen; ++i) {
+                ++counts[indices[i]];
+            }
+        }
+    }
+    if (useLanes) {
+        for (ui32 i = 0; i < numBuckets; ++i) {
+            counts[i] += laneCounts[i] + laneCounts[numBuckets + i] + laneCounts[2 * numBuckets + i] + laneCounts[3 * numBuckets + i];
+        }
+    }
+}
+
+// Returns true if the given `val` is in the range of the equal-width `layout`:
+// start <= val < start + numBuckets * width.
+template <typename T>
+inline bool IsInEqWidthRange(const TEqWidthLayout<T>& layout, T val) {
+    if (CmpLess<T>(val, layout.Start)) {
+        return false;
+    }
+    if constexpr (std::is_floating_point_v<T>) {
+        return ValueDiff<T>(val, layout.Start) < layout.Width * layout.NumBuckets;
+    } else {
+        return ValueDiff<T>(val, layout.Start) / layout.Width < layout.NumBuckets;
+    }
+}
+
+// Doubles the range of the equal-width `layout` in place: the width is doubled and pairs of adjacent
+// buckets are folded into one. The range is extended below the first start if `down`, above the end
+// otherwise. Returns false and keeps the buckets if the new starts do not fit the type `T`.
+template <typename T>
+bool GrowEqWidthLayout(TEqWidthLayout<T>& layout, bool down, T* starts, ui64* counts) {
+    const ui32 n = layout.NumBuckets;
+    Y_ASSERT(n >= 2);
+    const auto width = layout.Width;
+    TBucketWidth<T> newWidth;
+    T newStart = layout.Start;
+    if constexpr (std::is_floating_point_v<T>) {
+        newWidth = width * 2;
+        if (down) {
+            newStart = static_cast<T>(layout.Start - width * n);
+        }
+        if (!std::isfinite(newStart) || !std::isfinite(static_cast<T>(newStart + newWidth * (n - 1)))) {
+            return false;
+        }
+    } else {
+        if (width > std::numeric_limits<ui64>::max() / 2 / n) {
+            return false;
+        }
+        newWidth = width * 2;
+        if (down) {
+            if (ValueDiff<T>(layout.Start, std::numeric_limits<T>::lowest()) < width * n) {
+                return false;
+            }
+            newStart = static_cast<T>(static_cast<ui64>(layout.Start) - width * n);
+        }
+        if (ValueDiff<T>(std::numeric_limits<T>::max(), newStart) < newWidth * (n - 1)) {
+            return false;
+        }
+    }
+    if (down) {
+        // The old bucket `i` moves to `(n + i) / 2`, the new bucket `j` is read from the old buckets
+        // `2 * j - n` and `2 * j - n + 1`, which are never above `j`.
+        for (ui32 j = n; j-- > 0;) {
+            ui64 count = 0;
+            for (ui64 i = 2 * static_cast<ui64>(j); i < 2 * static_cast<ui64>(j) + 2; ++i) {
+                if (i >= n && i - n < n) {
+                    count += counts[i - n];
+                }
+            }
+            counts[j] = count;
+        }
+    } else {
+        // The old bucket `i` moves to `i / 2`.
+        for (ui32 j = 0; j < n; ++j) {
+            const ui64 i = 2 * static_cast<ui64>(j);
+            counts[j] = (i < n ? counts[i] : 0) + (i + 1 < n ? counts[i + 1] : 0);
+        }
+    }
+    for (ui32 i = 0; i < n; ++i) {
+        if constexpr (std::is_floating_point_v<T>) {
+            starts[i] = static_cast<T>(newStart + newWidth * i);
+        } else {
+            starts[i] = static_cast<T>(static_cast<ui64>(newStart) + i * newWidth);
+        }
+    }
+    layout.Start = newStart;
+    layout.Width = newWidth;
+    layout.InvWidth = 1.0 / static_cast<double>(newWidth);
+    return true;
+}
+
+// Distributes `counts` of buckets with the given boundaries `from` over buckets with the given
+// boundaries `to`, boundaries are offsets from a common origin, `n + 1` of them for `n` buckets.
+// Values are assumed to be uniformly distributed within a bucket, the values out of the `to` range
+// are counted in the nearest bucket. Cumulative counts are rounded, so the total count is preserved.
+// Linear in the number of buckets of both sides.
+void ProjectCounts(TArrayRef<const double> from, TArrayRef<const ui64> counts, TArrayRef<const double> to, TArrayRef<ui64> result);
+
+} // namespace NPrivate
+
+// Binary formats of a histogram.
+enum class EHistogramFormat: ui8 {
+    // [4 byte: number of buckets][1 byte: value type][16 bytes per bucket].
+    V1 = 1,
+    // Versioned compact format: the equal-width layout is stored as the start and the width,
+    // and counts are varint encoded.
+    V2 = 2,
+    // Versioned format of `TEqDepthHistogram`.
+    EqDepthV1 = 3,
+    // Versioned format of `TEqWidthHistogram2D`.
+    EqWidth2DV1 = 4,
+    // Versioned format of `TCompactEqWidthHistogram`, a storage format only, it is not estimated over.
+    CompactV1 = 5,
+};
+
+// The first 4 bytes of versioned formats, followed by the 1 byte `EHistogramFormat`.
+// The `V1` format never starts with it, since it never has zero buckets.
+constexpr ui32 HistogramVersionedFormatMarker = 0;
+
+namespace NPrivate {
+
+// Flags of the `V2` format.
+enum EFormatFlags: ui8 {
+    // Starts are stored as the first start and the width.
+    EqWidthLayoutFlag = 1,
+    // The distinct count sketch of the histogram follows the counts.
+    NdvFlag = 2,
+    // Distinct count sketches of buckets follow.
+    BucketNdvFlag = 4,
+};
+
+// Varint encoding of counts in the versioned formats, reading throws `yexception` if the varint
+// is malformed or truncated.
+char* WriteVarint(ui64 value, char* out);
+const char* ReadVarint(const char* in, const char* end, ui64& value);
+
+} // namespace NPrivate
+
 // This class represents an `Equal-width` histogram.
 // Each bucket represents a range of contiguous values of equal width, and the
 // aggregate summary stored in the bucket is the number of rows whose value lies
 // within that range.
+// Buckets are stored as a structure of arrays: the starts of buckets are a contiguous array of values
+// of the histogram type and the counts are a separate array, so lookups touch only the starts and
+// the prefix sums touch only the counts.
+// Arrays are allocated from the given memory resource, e.g. an arena shared by all histograms of a
+// table, see `TMemoryPoolResource`. Copies are allocated from the default resource. Distinct count
+// sketches of `EnableNdv()` always stay on the heap and are freed by the destructor.
 class TEqWidthHistogram {
 public:
 #pragma pack(push, 1)
+    // Bucket in the serialized representation.
     struct TBucket {
         // The number of values in a bucket.
         ui64 Count{0};
@@ -66,33 +566,166 @@ public:
 #pragma pack(pop)
 
     // Have to specify the number of buckets and type of the values.
-    TEqWidthHistogram(ui32 numBuckets = 1, EHistogramValueType type = EHistogramValueType::Int32);
-    // From serialized data.
-    TEqWidthHistogram(const char* str, ui64 size);
+    TEqWidthHistogram(ui32 numBuckets = 1, EHistogramValueType type = EHistogramValueType::Int32,
+                      std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    // From serialized data, in any of `EHistogramFormat` formats. Throws `yexception` if the data
+    // is malformed.
+    TEqWidthHistogram(const char* str, ui64 size, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    // From the given `starts` and `counts` of buckets.
+    template <typename T>
+    TEqWidthHistogram(EHistogramValueType type, TArrayRef<const T> starts, TArrayRef<const ui64> counts,
+                      std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : ValueType_(type)
+        , Counts_(resource)
+        , StartsStorage_(resource)
+    {
+        Y_ABORT_UNLESS(sizeof(T) == GetHistogramValueTypeSize(type));
+        Y_ABORT_UNLESS(starts.size() == counts.size() && !starts.empty());
+        AllocateBuckets(starts.size());
+        std::copy(starts.begin(), starts.end(), StartsData<T>());
+        std::copy(counts.begin(), counts.end(), Counts_.begin());
+        UpdateEqWidthLayout<T>();
+    }
 
-    // Adds the given `val` to a histogram.
+    // Adds the given `val` to a histogram, returns the index of the bucket it is counted in.
     template <typename T>
-    void AddElement(T val) {
-        const auto index = FindBucketIndex(val);
-        // The given `index` in range [0, numBuckets - 1].
-        const T bucketValue = LoadFrom<T>(Buckets_[index].Start);
-        if (!index || ((CmpEqual<T>(bucketValue, val) || CmpLess<T>(bucketValue, val)))) {
-            Buckets_[index].Count++;
-        } else {
-            Buckets_[index - 1].Count++;
+    ui32 AddElement(T val) {
+        const auto index = FindContainingBucketIndex<T>(val);
+        Counts_[index]++;
+        if (Y_UNLIKELY(Ndv_)) {
+            AddToNdv<T>(index, val);
+        }
+        return index;
+    }
+
+    // Adds the given `val` to a histogram, the range of the equal-width layout is grown until it
+    // covers `val`, see `NPrivate::GrowEqWidthLayout()`. Values which are still out of the range
+    // and values of other layouts are counted as by `AddElement()`. Returns true if the layout was
+    // changed. Estimators of a histogram have to be refreshed after the layout is changed.
+    template <typename T>
+    bool AddElementAdaptive(T val) {
+        const bool grown = GrowRangeTo<T>(val, val);
+        AddElement<T>(val);
+        return grown;
+    }
+
+    // Adds all the given `values` to a histogram as `AddElementAdaptive()` does, the range is grown
+    // once to cover the minimum and the maximum of `values`.
+    template <typename T>
+    bool AddElementsAdaptive(TArrayRef<const T> values) {
+        if (values.empty()) {
+            return false;
+        }
+        const auto [min, max] = std::minmax_element(values.begin(), values.end(), CmpLess<T>);
+        const bool grown = GrowRangeTo<T>(*min, *max);
+        AddElements<T>(values);
+        return grown;
+    }
+
+    // Changes the number of buckets to `numBuckets` keeping the range of a histogram, the last
+    // bucket is assumed to be as long as the previous one. New buckets have the equal width and
+    // counts are distributed over them proportionally, see `NPrivate::ProjectCounts()`, so
+    // histograms with different numbers of buckets over the same range can be aggregated.
+    // The number of integer buckets is reduced to the number of values in the range.
+    // Returns false for a single bucket, which range is unknown.
+    template <typename T>
+    bool Rebucket(ui32 numBuckets) {
+        Y_ABORT_UNLESS(numBuckets >= 1);
+        if (GetNumBuckets() < 2) {
+            return false;
+        }
+        const T first = GetBucketStart<T>(0);
+        const auto starts = NPrivate::MakeEqWidthStarts<T>(first, GetRangeMax<T>(), numBuckets);
+        TVector<ui64> counts(starts.size());
+        NPrivate::ProjectCounts(GetBucketOffsets<T>(GetStarts<T>(), first, GetLastBucketLength<T>()), GetCounts(),
+                                GetBucketOffsets<T>(starts, first, GetEqWidthLastLength<T>(starts)), counts);
+        SetBuckets<T>(starts, std::move(counts));
+        return true;
+    }
+
+    // Adds `count` elements to the bucket by the given `index`, distinct values are not counted.
+    void AddToBucket(ui32 index, ui64 count) {
+        Counts_[index] += count;
+    }
+
+    // Adds all the given `values` to a histogram, the result is the same as calling `AddElement()`
+    // for every value. For the equal-width layout bucket indices are computed arithmetically.
+    template <typename T>
+    void AddElements(TArrayRef<const T> values) {
+        if (values.empty()) {
+            return;
+        }
+        if (!EqWidthLayout_) {
+            if (!Ndv_ && GetNumBuckets() == 1) {
+                Counts_.front() += values.size();
+                return;
+            }
+            for (const auto& val : values) {
+                AddElement<T>(val);
+            }
+            return;
+        }
+        NPrivate::CountEqWidth<T>(GetEqWidthLayout<T>(), GetStartLoader<T>(), values, Counts_.data());
+        if (Y_UNLIKELY(Ndv_)) {
+            for (const auto& val : values) {
+                AddToNdv<T>(BucketNdv_.empty() ? 0 : FindContainingBucketIndex<T>(val), val);
+            }
         }
     }
 
+    // Enables the distinct counting of added values by the HyperLogLog sketch of the given
+    // `precision`, see `THyperLogLogSketch`, for the whole histogram and, if `bucketPrecision` is not
+    // zero, for every bucket. Values added before are not counted.
+    // Sketches are merged by `Aggregate()` with the same buckets, bucket sketches are dropped if the
+    // buckets are laid out again. A sketch is dropped by `Aggregate()` if the other histogram does
+    // not have it, since the result is unknown.
+    // Sketches are allocated from the heap, not from the memory resource of the histogram.
+    void EnableNdv(ui32 precision = 10, ui32 bucketPrecision = 0) {
+        Ndv_.emplace(precision);
+        BucketNdv_.clear();
+        if (bucketPrecision) {
+            BucketNdv_.assign(GetNumBuckets(), THyperLogLogSketch(bucketPrecision));
+        }
+    }
+    // Drops the sketches and stops the distinct counting.
+    void DisableNdv() {
+        Ndv_.reset();
+        BucketNdv_.clear();
+    }
+    // Returns true if the distinct values are counted for the whole histogram.
+    bool HasNdv() const {
+        return Ndv_.has_value();
+    }
+    // Returns true if the distinct values are counted for every bucket.
+    bool HasBucketNdv() const {
+        return !BucketNdv_.empty();
+    }
+    // Returns the estimated number of distinct values.
+    ui64 GetNdv() const {
+        Y_ABORT_UNLESS(Ndv_);
+        return Ndv_->Estimate();
+    }
+    // Returns the estimated number of distinct values in the bucket by the given `index`.
+    ui64 GetBucketNdv(ui32 index) const {
+        Y_ABORT_UNLESS(HasBucketNdv());
+        return BucketNdv_[index].Estimate();
+    }
+
     // Returns an index of the bucket which stores the given `val`.
     // Returned index in range [0, numBuckets - 1].
     // Not using `std::lower_bound()` here because need an index to map to `suffix` and `prefix` sum.
+    // Constant time for the equal-width layout, the binary search is used for other layouts.
     template <typename T>
     ui32 FindBucketIndex(T val) const {
+        if (EqWidthLayout_) {
+            return NPrivate::LowerBoundBucketIndex<T>(GetEqWidthLayout<T>(), GetStartLoader<T>(), val);
+        }
+        const T* starts = StartsData<T>();
         ui32 start = 0;
         ui32 end = GetNumBuckets() - 1;
         while (start < end) {
             auto it = start + (end - start) / 2;
-            if (CmpLess<T>(LoadFrom<T>(Buckets_[it].Start), val)) {
+            if (CmpLess<T>(starts[it], val)) {
                 start = it + 1;
             } else {
                 end = it;
@@ -101,24 +734,87 @@ public:
         return start;
     }
 
+    // Fills `indices` with `FindBucketIndex()` of every value of `values`.
+    // For layouts other than the equal-width one the values are sorted, and the starts are walked
+    // once for all of them.
+    template <typename T>
+    void FindBucketIndices(TArrayRef<const T> values, TArrayRef<ui32> indices) const {
+        Y_ABORT_UNLESS(values.size() == indices.size());
+        if (EqWidthLayout_ || values.size() < 2) {
+            for (size_t i = 0; i < values.size(); ++i) {
+                indices[i] = FindBucketIndex<T>(values[i]);
+            }
+            return;
+        }
+        TVector<ui32> order(values.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&values](ui32 left, ui32 right) {
+            return CmpLess<T>(values[left], values[right]);
+        });
+        const T* starts = StartsData<T>();
+        const ui32 last = GetNumBuckets() - 1;
+        ui32 bucket = 0;
+        for (const auto i : order) {
+            while (bucket < last && CmpLess<T>(starts[bucket], values[i])) {
+                ++bucket;
+            }
+            indices[i] = bucket;
+        }
+    }
+
+    // Returns an index of the bucket which contains the given `val`, this is the bucket `AddElement()`
+    // counts the value in.
+    template <typename T>
+    ui32 FindContainingBucketIndex(T val) const {
+        if (EqWidthLayout_) {
+            return NPrivate::ContainingBucketIndex<T>(GetEqWidthLayout<T>(), GetStartLoader<T>(), val);
+        }
+        return GetContainingBucketIndex<T>(FindBucketIndex(val), val);
+    }
+
+    // Returns `FindContainingBucketIndex(val)` given the `index` returned by `FindBucketIndex(val)`,
+    // e.g. found for many values at once by `FindBucketIndices()`.
+    template <typename T>
+    ui32 GetContainingBucketIndex(ui32 index, T val) const {
+        // The given `index` in range [0, numBuckets - 1].
+        const T bucketValue = GetBucketStart<T>(index);
+        if (EqWidthLayout_) {
+            // The arithmetic index compares exactly.
+            return index && CmpLess<T>(val, bucketValue) ? index - 1 : index;
+        }
+        if (!index || ((CmpEqual<T>(bucketValue, val) || CmpLess<T>(bucketValue, val)))) {
+            return index;
+        }
+        return index - 1;
+    }
+
     // Returns a number of buckets in a histogram.
     ui32 GetNumBuckets() const {
-        return Buckets_.size();
+        return Counts_.size();
     }
 
+    // Returns a number of values in a bucket, the width of the first one. One for floating point values.
     template <typename T>
-    ui32 GetBucketWidth() const {
+    ui64 GetBucketWidth() const {
         Y_ASSERT(GetNumBuckets());
         if (GetNumBuckets() == 1) {
-            return std::max(static_cast<ui32>(LoadFrom<T>(Buckets_.front().Start)), 1U);
+            return std::max<ui64>(static_cast<ui64>(GetBucketStart<T>(0)), 1);
         } else {
-            return std::max(static_cast<ui32>(LoadFrom<T>(Buckets_[1].Start) - LoadFrom<T>(Buckets_[0].Start)), 1U);
+            return std::max<ui64>(NPrivate::ValueDiff<T>(GetBucketStart<T>(1), GetBucketStart<T>(0)), 1);
         }
     }
 
-    template <>
-    ui32 GetBucketWidth<double>() const {
-        return 1;
+    // Returns a length of the bucket by the given `index`, for doubles as well. The last bucket is
+    // assumed to be as long as the previous one. Returns zero for a single bucket.
+    template <typename T>
+    double GetBucketLength(ui32 index) const {
+        if (GetNumBuckets() == 1) {
+            return 0;
+        }
+        if (index + 1 == GetNumBuckets()) {
+            --index;
+        }
+        return static_cast<double>(NPrivate::ValueDiff<T>(GetBucketStart<T>(index + 1), GetBucketStart<T>(index)));
     }
 
     // Returns histogram type.
@@ -127,119 +823,765 @@ public:
     }
     // Returns a number of elements in a bucket by the given `index`.
     ui64 GetNumElementsInBucket(ui32 index) const {
-        return Buckets_[index].Count;
+        return Counts_[index];
+    }
+    // Sets counts of all buckets to zero, keeps the layout. Distinct counts are reset as well, so
+    // they count only the values added after. If counts are then set by `AddToBucket()` rather
+    // than by adding values, distinct counting has to be merged or disabled by `DisableNdv()`.
+    void ResetCounts() {
+        std::fill(Counts_.begin(), Counts_.end(), 0);
+        if (Ndv_) {
+            Ndv_->Reset();
+        }
+        for (auto& ndv : BucketNdv_) {
+            ndv.Reset();
+        }
+    }
+    // Subtracts the given `counts` of buckets, which must not exceed the counts of the histogram.
+    // Distinct counts are kept, values can not be removed from sketches.
+    void SubtractCounts(TArrayRef<const ui64> counts) {
+        Y_ABORT_UNLESS(counts.size() == Counts_.size());
+        for (ui32 i = 0; i < counts.size(); ++i) {
+            Y_ASSERT(counts[i] <= Counts_[i]);
+            Counts_[i] -= counts[i];
+        }
+    }
+    // Returns a number of bytes allocated by the histogram, including the object itself.
+    ui64 GetAllocatedSize() const;
+    // Returns counts of all buckets.
+    TArrayRef<const ui64> GetCounts() const {
+        return {Counts_.data(), Counts_.size()};
+    }
+    // Returns a start of the bucket by the given `index`.
+    template <typename T>
+    T GetBucketStart(ui32 index) const {
+        return StartsData<T>()[index];
+    }
+    // Returns starts of all buckets, `T` has to match the histogram type.
+    template <typename T>
+    TArrayRef<const T> GetStarts() const {
+        return {StartsData<T>(), GetNumBuckets()};
     }
 
-    // Initializes buckets with a given `range`.
+    // Initializes buckets with a given `range`: the buckets have the equal width and the last one
+    // starts not after `range.End`, see `NPrivate::MakeEqWidthStarts()`. If the range has fewer
+    // integer values than buckets, the remaining buckets have the unit width. Buckets which would
+    // start past the maximum of `T` are dropped, so starts never overflow or repeat.
     template <typename T>
     void InitializeBuckets(const TBucketRange& range) {
         Y_ASSERT(CmpLess<T>(LoadFrom<T>(range.Start), LoadFrom<T>(range.End)));
-        T rangeLen = LoadFrom<T>(range.End) - LoadFrom<T>(range.Start);
-        std::memcpy(Buckets_[0].Start, range.Start, sizeof(range.Start));
-        for (ui32 i = 1; i < GetNumBuckets(); ++i) {
-            const T prevStart = LoadFrom<T>(Buckets_[i - 1].Start);
-            StoreTo<T>(Buckets_[i].Start, prevStart + rangeLen);
+        const ui32 numBuckets = NPrivate::FillEqWidthStarts<T>(LoadFrom<T>(range.Start), LoadFrom<T>(range.End), {StartsData<T>(), GetNumBuckets()});
+        Counts_.resize(numBuckets);
+        if (!BucketNdv_.empty()) {
+            BucketNdv_.resize(numBuckets);
         }
+        UpdateEqWidthLayout<T>();
     }
 
     // Seriailizes to a binary representation
-    std::unique_ptr<char> Serialize(ui64& binSize) const;
-    // Returns buckets.
-    const TVector<TBucket>& GetBuckets() const {
-        return Buckets_;
+    std::unique_ptr<char[]> Serialize(ui64& binSize, EHistogramFormat format = EHistogramFormat::V1) const;
+    // Serializes to the given `output`.
+    void SerializeTo(IOutputStream& output, EHistogramFormat format = EHistogramFormat::V1) const;
+    // Serializes to the given `buffer`, which has to hold at least `GetSerializedSize()` bytes.
+    // Returns a number of written bytes.
+    ui64 SerializeTo(TArrayRef<char> buffer, EHistogramFormat format = EHistogramFormat::V1) const;
+    // Returns a size of the binary representation.
+    ui64 GetSerializedSize(EHistogramFormat format = EHistogramFormat::V1) const;
+
+    // Adds counts of the `other` histogram, returns false if the types are different.
+    // If the buckets are different, both histograms are projected onto the equal-width layout with
+    // the number of buckets of this histogram covering the ranges of both, see `Rebucket()`, so
+    // histograms built from local ranges of shards can be merged. Linear in the number of buckets.
+    template <typename T>
+    bool Aggregate(const TEqWidthHistogram& other) {
+        if (this->ValueType_ != other.GetType()) {
+            return false;
+        }
+        if (!BucketsEqual<T>(other)) {
+            const T min = CmpLess<T>(other.GetBucketStart<T>(0), GetBucketStart<T>(0)) ? other.GetBucketStart<T>(0) : GetBucketStart<T>(0);
+            const T max = CmpLess<T>(GetRangeMax<T>(), other.GetRangeMax<T>()) ? other.GetRangeMax<T>() : GetRangeMax<T>();
+            auto starts = NPrivate::MakeEqWidthStarts<T>(min, max, GetNumBuckets());
+            const auto to = GetBucketOffsets<T>(starts, min, GetEqWidthLastLength<T>(starts));
+            TVector<ui64> counts(starts.size());
+            TVector<ui64> otherCounts(starts.size());
+            NPrivate::ProjectCounts(GetBucketOffsets<T>(GetStarts<T>(), min, GetLastBucketLength<T>()), GetCounts(), to, counts);
+            NPrivate::ProjectCounts(other.GetBucketOffsets<T>(other.GetStarts<T>(), min, other.GetLastBucketLength<T>()), other.GetCounts(), to, otherCounts);
+            for (ui32 i = 0; i < counts.size(); ++i) {
+                counts[i] += otherCounts[i];
+            }
+            SetBuckets<T>(starts, std::move(counts));
+            MergeNdv(other, false);
+            return true;
+        }
+        const auto otherCounts = other.GetCounts();
+        for (ui32 i = 0; i < Counts_.size(); ++i) {
+            Counts_[i] += otherCounts[i];
+        }
+        MergeNdv(other, true);
+        return true;
     }
 
+    // Returns true if the starts of buckets are equal to the ones of the `other` histogram.
     template <typename T>
-    void Aggregate(const TEqWidthHistogram& other) {
-        if ((this->ValueType_ != other.GetType()) || (!BucketsEqual<T>(other))) {
-            // Should we fail?
-            return;
+    bool BucketsEqual(const TEqWidthHistogram& other) const {
+        if (GetNumBuckets() != other.GetNumBuckets()) {
+            return false;
         }
-        for (ui32 i = 0; i < Buckets_.size(); ++i) {
-            Buckets_[i].Count += other.GetBuckets()[i].Count;
+        for (ui32 i = 0; i < GetNumBuckets(); ++i) {
+            if (!CmpEqual<T>(GetBucketStart<T>(i), other.GetBucketStart<T>(i))) {
+                return false;
+            }
         }
+        return true;
+    }
+
+    // Returns true if the buckets are laid out with the equal width, in that case bucket indices
+    // are computed arithmetically.
+    bool IsEqWidthLayout() const {
+        return EqWidthLayout_;
     }
 
 private:
     template <typename T>
-    bool BucketsEqual(const TEqWidthHistogram& other) {
-        if (Buckets_.size() != other.GetNumBuckets()) {
+    const T* StartsData() const {
+        Y_ASSERT(sizeof(T) == GetHistogramValueTypeSize(ValueType_));
+        return reinterpret_cast<const T*>(StartsStorage_.data());
+    }
+    template <typename T>
+    T* StartsData() {
+        Y_ASSERT(sizeof(T) == GetHistogramValueTypeSize(ValueType_));
+        return reinterpret_cast<T*>(StartsStorage_.data());
+    }
+    // Returns a pointer to the start of the bucket by the given `index` for the type erased access.
+    const ui8* GetStartBytes(ui32 index) const {
+        return reinterpret_cast<const ui8*>(StartsStorage_.data()) + index * GetHistogramValueTypeSize(ValueType_);
+    }
+    ui8* GetStartBytes(ui32 index) {
+        return reinterpret_cast<ui8*>(StartsStorage_.data()) + index * GetHistogramValueTypeSize(ValueType_);
+    }
+    // Allocates buckets for the current value type.
+    void AllocateBuckets(ui32 numBuckets);
+
+    template <typename T>
+    auto GetStartLoader() const {
+        return [starts = StartsData<T>()](ui32 index) {
+            return starts[index];
+        };
+    }
+
+    template <typename T>
+    NPrivate::TEqWidthLayout<T> GetEqWidthLayout() const {
+        NPrivate::TEqWidthLayout<T> layout;
+        layout.Start = LoadFrom<T>(LayoutStart_);
+        layout.Width = LoadFrom<NPrivate::TBucketWidth<T>>(LayoutWidth_);
+        layout.InvWidth = LayoutInvWidth_;
+        layout.NumBuckets = GetNumBuckets();
+        return layout;
+    }
+
+    template <typename T>
+    void SetEqWidthLayout(const NPrivate::TEqWidthLayout<T>& layout) {
+        StoreTo<T>(LayoutStart_, layout.Start);
+        StoreTo<NPrivate::TBucketWidth<T>>(LayoutWidth_, layout.Width);
+        LayoutInvWidth_ = layout.InvWidth;
+    }
+
+    // Recomputes the cached layout, has to be called after the starts of buckets are changed.
+    template <typename T>
+    void UpdateEqWidthLayout() {
+        NPrivate::TEqWidthLayout<T> layout;
+        EqWidthLayout_ = NPrivate::DetectEqWidthLayout<T>(GetNumBuckets(), GetStartLoader<T>(), layout);
+        if (EqWidthLayout_) {
+            SetEqWidthLayout<T>(layout);
+        }
+    }
+    void UpdateEqWidthLayout();
+
+    // Replaces buckets with the given ones.
+    template <typename T>
+    void SetBuckets(const TVector<T>& starts, TVector<ui64>&& counts) {
+        Y_ASSERT(starts.size() == counts.size());
+        AllocateBuckets(starts.size());
+        std::copy(starts.begin(), starts.end(), StartsData<T>());
+        Counts_.assign(counts.begin(), counts.end());
+        // Distinct values of the new buckets are unknown.
+        BucketNdv_.clear();
+        UpdateEqWidthLayout<T>();
+    }
+
+    template <typename T>
+    void AddToNdv(ui32 index, T val) {
+        if constexpr (std::is_floating_point_v<T>) {
+            if (std::isnan(val)) {
+                return;
+            }
+        }
+        const ui64 hash = HashHistogramValue<T>(val);
+        Ndv_->AddHash(hash);
+        if (!BucketNdv_.empty()) {
+            BucketNdv_[index].AddHash(hash);
+        }
+    }
+    // Folds bucket sketches the same way as `NPrivate::GrowEqWidthLayout()` folds counts.
+    void FoldBucketNdv(bool down);
+    // Merges sketches of the `other` histogram, see `EnableNdv()`.
+    void MergeNdv(const TEqWidthHistogram& other, bool sameBuckets);
+
+    // Returns the length of the last bucket: the length of the previous one, or a single value for
+    // a single bucket.
+    template <typename T>
+    double GetLastBucketLength() const {
+        if (GetNumBuckets() == 1) {
+            return std::is_floating_point_v<T> ? 0.0 : 1.0;
+        }
+        return GetBucketLength<T>(GetNumBuckets() - 1);
+    }
+    // The same for the given equal-width `starts`.
+    template <typename T>
+    static double GetEqWidthLastLength(const TVector<T>& starts) {
+        if (starts.size() == 1) {
+            return std::is_floating_point_v<T> ? 0.0 : 1.0;
+        }
+        return static_cast<double>(NPrivate::ValueDiff<T>(starts[1], starts[0]));
+    }
+
+    // Returns the maximum value in the range of a histogram: the last value of the last bucket for
+    // integers, which is clamped to the type, or the end of the last bucket for doubles.
+    template <typename T>
+    T GetRangeMax() const {
+        const ui32 n = GetNumBuckets();
+        const T lastStart = GetBucketStart<T>(n - 1);
+        if (n == 1) {
+            return lastStart;
+        }
+        if constexpr (std::is_floating_point_v<T>) {
+            return static_cast<T>(lastStart + GetBucketLength<T>(n - 1));
+        } else {
+            const ui64 lastWidth = NPrivate::ValueDiff<T>(lastStart, GetBucketStart<T>(n - 2));
+            const ui64 room = NPrivate::ValueDiff<T>(std::numeric_limits<T>::max(), lastStart);
+            return static_cast<T>(static_cast<ui64>(lastStart) + std::min(lastWidth - 1, room));
+        }
+    }
+
+    // Returns boundaries of buckets with the given `starts` as offsets from the `origin`, the last
+    // bucket has the given `lastLength`, see `NPrivate::ProjectCounts()`.
+    template <typename T>
+    static TVector<double> GetBucketOffsets(TArrayRef<const T> starts, T origin, double lastLength) {
+        TVector<double> offsets(starts.size() + 1);
+        for (ui32 i = 0; i < starts.size(); ++i) {
+            offsets[i] = static_cast<double>(NPrivate::ValueDiff<T>(starts[i], origin));
+        }
+        offsets.back() = offsets[starts.size() - 1] + lastLength;
+        return offsets;
+    }
+    template <typename T>
+    static TVector<double> GetBucketOffsets(const TVector<T>& starts, T origin, double lastLength) {
+        return GetBucketOffsets<T>(TArrayRef<const T>(starts.data(), starts.size()), origin, lastLength);
+    }
+
+    // Grows the range of the equal-width layout until it covers [min, max] or can not be grown. If
+    // it can not be grown below `min`, it is still grown up to cover `max`.
+    // Returns true if the layout was changed.
+    template <typename T>
+    bool GrowRangeTo(T min, T max) {
+        if (!EqWidthLayout_) {
             return false;
         }
-        for (ui32 i = 0; i < Buckets_.size(); ++i) {
-            if (!CmpEqual<T>(LoadFrom<T>(Buckets_[i].Start), LoadFrom<T>(GetBuckets()[i].Start))) {
+        if constexpr (std::is_floating_point_v<T>) {
+            if (std::isnan(min) || std::isnan(max)) {
                 return false;
             }
         }
-        return true;
+        auto layout = GetEqWidthLayout<T>();
+        bool grown = false;
+        bool canGrowDown = true;
+        while (true) {
+            const bool down = canGrowDown && CmpLess<T>(min, layout.Start);
+            if (!down && (CmpLess<T>(max, layout.Start) || NPrivate::IsInEqWidthRange<T>(layout, max))) {
+                break;
+            }
+            if (NPrivate::GrowEqWidthLayout<T>(layout, down, StartsData<T>(), Counts_.data())) {
+                FoldBucketNdv(down);
+                grown = true;
+                continue;
+            }
+            if (!down) {
+                break;
+            }
+            // The range can not be extended below, `max` could still be covered by growing up.
+            canGrowDown = false;
+        }
+        if (grown) {
+            SetEqWidthLayout<T>(layout);
+        }
+        return grown;
     }
 
+    // Serializes buckets in [from, to) to the given `binaryData`.
+    void SerializeBucketsTo(ui32 from, ui32 to, char* binaryData) const;
+    // Serializes in the `V2` format, `write(data, size)` is called for the consecutive parts.
+    template <typename TWrite>
+    void SerializeV2(TWrite&& write) const;
+    // Initializes from the `V2` format.
+    void DeserializeV2(const char* str, ui64 size);
+    // Returns true if starts are exactly reproduced from the first start and the width.
+    bool IsCompactLayout() const;
     // Returns binary size of the histogram.
     ui64 GetBinarySize(ui32 nBuckets) const;
     EHistogramValueType ValueType_;
-    TVector<TBucket> Buckets_;
+    std::pmr::vector<ui64> Counts_;
+    // Starts of buckets, `ui64` elements keep the array aligned for any value type.
+    std::pmr::vector<ui64> StartsStorage_;
+    // Cached equal-width layout: the first start, the width and its reciprocal.
+    bool EqWidthLayout_{false};
+    ui8 LayoutStart_[EqWidthHistogramBucketStorageSize]{};
+    ui8 LayoutWidth_[EqWidthHistogramBucketStorageSize]{};
+    double LayoutInvWidth_{0};
+    // Optional distinct counting, see `EnableNdv()`. On the heap, whatever the memory resource is.
+    std::optional<THyperLogLogSketch> Ndv_;
+    TVector<THyperLogLogSketch> BucketNdv_;
+};
+
+template <>
+inline ui64 TEqWidthHistogram::GetBucketWidth<double>() const {
+    return 1;
+}
+template <>
+inline ui64 TEqWidthHistogram::GetBucketWidth<float>() const {
+    return 1;
+}
+
+// Receives the numbers of lookups of estimators with `TEqWidthHistogramEstimator::TSettings::Counters`,
+// e.g. the monitoring counters of `counters/eq_width_histogram_counters.h`.
+class IEqWidthHistogramEstimatorCounters {
+public:
+    virtual ~IEqWidthHistogramEstimatorCounters() = default;
+
+    virtual void OnLookups(ui64 count) = 0;
 };
 
 // This class represents a machinery to estimate a value in a histogram.
 class TEqWidthHistogramEstimator {
 public:
+    enum class EMode {
+        // Prefix sums are precomputed: estimates are O(1), updates are O(N).
+        Static,
+        // Prefix sums are kept in a Fenwick tree: estimates and updates are O(log N).
+        Incremental,
+    };
+
+    struct TSettings {
+        EMode Mode = EMode::Static;
+        // Interpolate range estimates linearly within the bucket the value falls into, instead of
+        // counting the whole bucket.
+        bool Interpolate = false;
+        // The rate of the sample the histogram is built from, see `TSampledEqWidthHistogramBuilder`.
+        double SampleRate = 1.0;
+        // Counts lookups if set, has to outlive the estimator.
+        IEqWidthHistogramEstimatorCounters* Counters = nullptr;
+    };
+
+    // An estimate with bounds of the exact number derived from bucket boundaries: only the buckets
+    // which the given values fall into are uncertain. The estimate is clamped to the bounds. For a
+    // sampled histogram the bounds are of the sampled counts, see `GetStandardError()`.
+    struct TBoundedEstimate {
+        ui64 Estimate{0};
+        ui64 Lower{0};
+        ui64 Upper{0};
+    };
+
     TEqWidthHistogramEstimator(std::shared_ptr<TEqWidthHistogram> histogram);
+    TEqWidthHistogramEstimator(std::shared_ptr<TEqWidthHistogram> histogram, TSettings settings);
+    // Does not own the `histogram`, which has to outlive the estimator. Prefix sums are allocated
+    // from the given memory resource, so estimators could live in the same arena as histograms.
+    TEqWidthHistogramEstimator(TEqWidthHistogram& histogram, TSettings settings,
+                               std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
     // Methods to estimate values.
     template <typename T>
     ui64 EstimateLessOrEqual(T val) const {
-        return EstimateOrEqual<T>(val, PrefixSum_);
+        OnLookups(1);
+        if (Settings_.Interpolate) {
+            return Round(EstimateLessInterpolated<T>(val, true));
+        }
+        return GetPrefixSum(Histogram_->FindBucketIndex(val));
     }
 
     template <typename T>
     ui64 EstimateGreaterOrEqual(T val) const {
-        return EstimateOrEqual<T>(val, SuffixSum_);
+        OnLookups(1);
+        if (Settings_.Interpolate) {
+            return Round(NumElements_ - EstimateLessInterpolated<T>(val, false));
+        }
+        return GetSuffixSum(Histogram_->FindBucketIndex(val));
     }
 
     template <typename T>
     ui64 EstimateLess(T val) const {
-        return EstimateNotEqual<T>(val, PrefixSum_);
+        OnLookups(1);
+        if (Settings_.Interpolate) {
+            return Round(EstimateLessInterpolated<T>(val, false));
+        }
+        const auto index = Histogram_->FindBucketIndex(val);
+        // Take the previous backet if it's not the first one.
+        return GetPrefixSum(index ? index - 1 : index);
     }
 
     template <typename T>
     ui64 EstimateGreater(T val) const {
-        return EstimateNotEqual<T>(val, SuffixSum_);
+        OnLookups(1);
+        if (Settings_.Interpolate) {
+            return Round(NumElements_ - EstimateLessInterpolated<T>(val, true));
+        }
+        const auto index = Histogram_->FindBucketIndex(val);
+        // Take the previous backet if it's not the first one.
+        return GetSuffixSum(index ? index - 1 : index);
     }
 
     template <typename T>
     ui64 EstimateEqual(T val) const {
-        const auto index = Histogram_->FindBucketIndex(val);
-        // Assuming uniform distribution.
-        return std::max(1U, static_cast<ui32>(Histogram_->GetNumElementsInBucket(index) / Histogram_->template GetBucketWidth<T>()));
+        OnLookups(1);
+        return EstimateEqualInBucket<T>(Histogram_->FindContainingBucketIndex(val));
+    }
+
+    // Batch versions of the methods above, estimate every value of `values` into `result`.
+    // Bucket indices of all values are found at once, see `TEqWidthHistogram::FindBucketIndices()`,
+    // interpolation takes the containing buckets from them.
+    template <typename T>
+    void EstimateLessOrEqualBatch(TArrayRef<const T> values, TArrayRef<ui64> result) const {
+        EstimateBatch<T>(values, result, [this](T val, ui32 index) {
+            return Settings_.Interpolate ? Round(EstimateLessInterpolated<T>(val, GetContainingIndex<T>(index, val), true)) : GetPrefixSum(index);
+        });
+    }
+
+    template <typename T>
+    void EstimateGreaterOrEqualBatch(TArrayRef<const T> values, TArrayRef<ui64> result) const {
+        EstimateBatch<T>(values, result, [this](T val, ui32 index) {
+            return Settings_.Interpolate ? Round(NumElements_ - EstimateLessInterpolated<T>(val, GetContainingIndex<T>(index, val), false)) : GetSuffixSum(index);
+        });
+    }
+
+    template <typename T>
+    void EstimateLessBatch(TArrayRef<const T> values, TArrayRef<ui64> result) const {
+        EstimateBatch<T>(values, result, [this](T val, ui32 index) {
+            return Settings_.Interpolate ? Round(EstimateLessInterpolated<T>(val, GetContainingIndex<T>(index, val), false)) : GetPrefixSum(index ? index - 1 : index);
+        });
+    }
+
+    template <typename T>
+    void EstimateGreaterBatch(TArrayRef<const T> values, TArrayRef<ui64> result) const {
+        EstimateBatch<T>(values, result, [this](T val, ui32 index) {
+            return Settings_.Interpolate ? Round(NumElements_ - EstimateLessInterpolated<T>(val, GetContainingIndex<T>(index, val), true)) : GetSuffixSum(index ? index - 1 : index);
+        });
+    }
+
+    template <typename T>
+    void EstimateEqualBatch(TArrayRef<const T> values, TArrayRef<ui64> result) const {
+        EstimateBatch<T>(values, result, [this](T val, ui32 index) {
+            return EstimateEqualInBucket<T>(GetContainingIndex<T>(index, val));
+        });
+    }
+
+    // Returns a number of elements in the range [lo, hi].
+    template <typename T>
+    ui64 EstimateRange(T lo, T hi) const {
+        OnLookups(1);
+        if (CmpLess<T>(hi, lo)) {
+            return 0;
+        }
+        if (Settings_.Interpolate) {
+            return Round(std::max(0.0, EstimateLessInterpolated<T>(hi, true) - EstimateLessInterpolated<T>(lo, false)));
+        }
+        const ui64 lessOrEqual = GetPrefixSum(Histogram_->FindBucketIndex(hi));
+        const auto index = Histogram_->FindBucketIndex(lo);
+        const ui64 less = GetPrefixSum(index ? index - 1 : index);
+        return lessOrEqual > less ? lessOrEqual - less : 0;
+    }
+
+    // Versions of the methods above with bounds of the exact number, see `TBoundedEstimate`.
+    template <typename T>
+    TBoundedEstimate EstimateLessOrEqualWithBounds(T val) const {
+        const auto [lower, upper] = GetLessBounds<T>(val, true);
+        return MakeBounded(EstimateLessOrEqual<T>(val), lower, upper);
+    }
+
+    template <typename T>
+    TBoundedEstimate EstimateLessWithBounds(T val) const {
+        const auto [lower, upper] = GetLessBounds<T>(val, false);
+        return MakeBounded(EstimateLess<T>(val), lower, upper);
+    }
+
+    template <typename T>
+    TBoundedEstimate EstimateGreaterOrEqualWithBounds(T val) const {
+        const auto [lower, upper] = GetLessBounds<T>(val, false);
+        return MakeBounded(EstimateGreaterOrEqual<T>(val), NumElements_ - upper, NumElements_ - lower);
+    }
+
+    template <typename T>
+    TBoundedEstimate EstimateGreaterWithBounds(T val) const {
+        const auto [lower, upper] = GetLessBounds<T>(val, true);
+        return MakeBounded(EstimateGreater<T>(val), NumElements_ - upper, NumElements_ - lower);
+    }
+
+    template <typename T>
+    TBoundedEstimate EstimateEqualWithBounds(T val) const {
+        const auto index = Histogram_->FindContainingBucketIndex<T>(val);
+        const ui64 count = Histogram_->GetNumElementsInBucket(index);
+        ui64 lower = 0;
+        if constexpr (!std::is_floating_point_v<T>) {
+            // A bucket of a single value.
+            if (index + 1 < Histogram_->GetNumBuckets() && index && CmpEqual<T>(val, Histogram_->template GetBucketStart<T>(index)) &&
+                static_cast<T>(val + 1) == Histogram_->template GetBucketStart<T>(index + 1)) {
+                lower = count;
+            }
+        }
+        OnLookups(1);
+        return MakeBounded(EstimateEqualInBucket<T>(index), lower, count);
+    }
+
+    template <typename T>
+    TBoundedEstimate EstimateRangeWithBounds(T lo, T hi) const {
+        if (CmpLess<T>(hi, lo)) {
+            return MakeBounded(EstimateRange<T>(lo, hi), 0, 0);
+        }
+        const auto [lessOrEqualLower, lessOrEqualUpper] = GetLessBounds<T>(hi, true);
+        const auto [lessLower, lessUpper] = GetLessBounds<T>(lo, false);
+        return MakeBounded(EstimateRange<T>(lo, hi), lessOrEqualLower > lessUpper ? lessOrEqualLower - lessUpper : 0,
+                           lessOrEqualUpper - std::min(lessOrEqualUpper, lessLower));
+    }
+
+    // Returns the value `val` such that the estimated number of elements less than `val` is the `p`
+    // part of all elements, `p` is clamped to [0, 1]. This is the inverse of `EstimateLess()` with
+    // interpolation: values are assumed to be uniformly distributed within a bucket.
+    template <typename T>
+    T GetQuantile(double p) const {
+        const double target = std::clamp(p, 0.0, 1.0) * NumElements_;
+        // The first bucket which prefix sum reaches `target`, so empty buckets are skipped.
+        ui32 lo = 0;
+        ui32 hi = Histogram_->GetNumBuckets() - 1;
+        while (lo < hi) {
+            const ui32 mid = lo + (hi - lo) / 2;
+            if (static_cast<double>(GetPrefixSum(mid)) < target) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        const T start = Histogram_->template GetBucketStart<T>(lo);
+        const ui64 count = Histogram_->GetNumElementsInBucket(lo);
+        if (!count) {
+            return start;
+        }
+        const double before = lo ? static_cast<double>(GetPrefixSum(lo - 1)) : 0.0;
+        const double offset = std::clamp((target - before) / count, 0.0, 1.0) * Histogram_->template GetBucketLength<T>(lo);
+        if constexpr (std::is_floating_point_v<T>) {
+            return static_cast<T>(start + offset);
+        } else {
+            // The last bucket could be assumed to go past the maximum of `T`.
+            const ui64 maxOffset = NPrivate::ValueDiff<T>(std::numeric_limits<T>::max(), start);
+            return static_cast<T>(static_cast<ui64>(start) + std::min(static_cast<ui64>(offset), maxOffset));
+        }
+    }
+
+    // Returns at most `numParts - 1` increasing values which split elements into `numParts` parts
+    // of roughly the same number of elements, e.g. to range partition a scan: the part `i` holds
+    // values in [points[i - 1], points[i]). Fewer points are returned if some of them coincide,
+    // e.g. for a skewed column or a range with fewer integer values than parts. No points are
+    // returned for an empty histogram.
+    template <typename T>
+    TVector<T> GetSplitPoints(ui32 numParts) const {
+        TVector<T> points;
+        if (!NumElements_) {
+            return points;
+        }
+        for (ui32 i = 1; i < numParts; ++i) {
+            const T point = GetQuantile<T>(static_cast<double>(i) / numParts);
+            if (points.empty() || CmpLess<T>(points.back(), point)) {
+                points.push_back(point);
+            }
+        }
+        return points;
+    }
+
+    // Returns the standard error of the given `estimate` caused by sampling: the number of sampled
+    // rows of the estimated ones is binomial, so the error is sqrt(estimate * (1 - rate) / rate).
+    // Zero for a histogram of all rows, the error of the uniformity within a bucket is not included.
+    double GetStandardError(ui64 estimate) const {
+        if (Settings_.SampleRate >= 1) {
+            return 0;
+        }
+        return std::sqrt(estimate * (1 - Settings_.SampleRate) / Settings_.SampleRate);
     }
 
     // Returns the total number elements in histogram.
     // Could be used to adjust scale.
     ui64 GetNumElements() const {
-        return PrefixSum_.back();
+        return NumElements_;
     }
 
-private:
+    const TEqWidthHistogram& GetHistogram() const {
+        return *Histogram_;
+    }
+    // Returns a number of bytes allocated by the estimator, including the histogram if owned.
+    ui64 GetAllocatedSize() const;
+
+    // Adds the given `val` to the histogram and updates the estimator.
     template <typename T>
-    ui64 EstimateOrEqual(T val, const TVector<ui64>& sumArray) const {
-        const auto index = Histogram_->FindBucketIndex(val);
-        return sumArray[index];
+    void AddElement(T val) {
+        UpdateBucket(Histogram_->AddElement<T>(val), 1);
     }
 
+    // Aggregates the `other` histogram into the histogram and updates the estimator.
     template <typename T>
-    ui64 EstimateNotEqual(T val, const TVector<ui64>& sumArray) const {
-        const auto index = Histogram_->FindBucketIndex(val);
-        // Take the previous backet if it's not the first one.
-        if (!index) {
-            return sumArray[index];
+    void Aggregate(const TEqWidthHistogram& other) {
+        const bool sameBuckets = Histogram_->GetType() == other.GetType() && Histogram_->BucketsEqual<T>(other);
+        if (!Histogram_->Aggregate<T>(other)) {
+            return;
+        }
+        if (Settings_.Mode == EMode::Static || !sameBuckets) {
+            Refresh();
+            return;
         }
-        return sumArray[index - 1];
+        for (ui32 i = 0; i < other.GetNumBuckets(); ++i) {
+            if (const auto count = other.GetNumElementsInBucket(i)) {
+                UpdateBucket(i, count);
+            }
+        }
+        RefreshNdv();
+    }
+
+    // Rebuilds the prefix sums and the distinct counts, has to be called if the histogram was changed
+    // not by the estimator, distinct counts are not updated by `AddElement()`.
+    void Refresh();
+
+private:
+    template <typename T, typename TEstimate>
+    void EstimateBatch(TArrayRef<const T> values, TArrayRef<ui64> result, TEstimate&& estimate) const {
+        Y_ABORT_UNLESS(values.size() == result.size());
+        OnLookups(values.size());
+        TVector<ui32> indices(values.size());
+        Histogram_->FindBucketIndices<T>(values, indices);
+        for (size_t i = 0; i < values.size(); ++i) {
+            result[i] = estimate(values[i], indices[i]);
+        }
+    }
+
+    // Returns an interpolated number of elements less than `val`, or less or equal if `orEqual`.
+    // Values are assumed to be uniformly distributed within a bucket: for integers over the
+    // `width` values of the bucket, for doubles over the length of the bucket.
+    template <typename T>
+    double EstimateLessInterpolated(T val, bool orEqual) const {
+        return EstimateLessInterpolated<T>(val, Histogram_->FindContainingBucketIndex(val), orEqual);
+    }
+    // The same given the `index` of the bucket containing `val`.
+    template <typename T>
+    double EstimateLessInterpolated(T val, ui32 index, bool orEqual) const {
+        const T start = Histogram_->template GetBucketStart<T>(index);
+        const double before = index ? static_cast<double>(GetPrefixSum(index - 1)) : 0.0;
+        const double count = static_cast<double>(Histogram_->GetNumElementsInBucket(index));
+        if (CmpLess<T>(val, start)) {
+            // Below the first bucket.
+            return 0;
+        }
+        const double length = Histogram_->template GetBucketLength<T>(index);
+        if (length <= 0) {
+            // Nothing to interpolate by.
+            return orEqual ? before + count : before;
+        }
+        double offset = static_cast<double>(NPrivate::ValueDiff<T>(val, start));
+        if constexpr (!std::is_floating_point_v<T>) {
+            offset += orEqual ? 1 : 0;
+        }
+        return before + count * std::min(1.0, offset / length);
+    }
+    // Returns the number of elements equal to a value in the bucket by the given `index`, assuming
+    // values are uniformly distributed over the distinct values of the bucket.
+    // A zero distinct count of a non empty bucket is unknown, e.g. counts were added by
+    // `TEqWidthHistogram::AddToBucket()`.
+    template <typename T>
+    ui64 EstimateEqualInBucket(ui32 index) const {
+        const ui64 count = Histogram_->GetNumElementsInBucket(index);
+        if (!BucketNdv_.empty() && (BucketNdv_[index] || !count)) {
+            return std::max<ui64>(1, count / std::max<ui64>(1, BucketNdv_[index]));
+        }
+        const ui64 width = Histogram_->template GetBucketWidth<T>();
+        if (HasNdv_ && NumElements_) {
+            // Distinct values of the column are spread over buckets proportionally to counts.
+            double distinct = static_cast<double>(Ndv_) * count / NumElements_;
+            if constexpr (!std::is_floating_point_v<T>) {
+                distinct = std::min<double>(distinct, width);
+            }
+            return std::max<ui64>(1, static_cast<ui64>(count / std::max(1.0, distinct)));
+        }
+        // Assuming all values of the bucket are present.
+        return std::max<ui64>(1, count / width);
+    }
+    // Returns the index of the bucket containing `val` given the `index` found by `FindBucketIndex()`.
+    template <typename T>
+    ui32 GetContainingIndex(ui32 index, T val) const {
+        return Histogram_->template GetContainingBucketIndex<T>(index, val);
+    }
+    static ui64 Round(double value) {
+        return static_cast<ui64>(std::max(0.0, value) + 0.5);
+    }
+    static TBoundedEstimate MakeBounded(ui64 estimate, ui64 lower, ui64 upper) {
+        return {std::clamp(estimate, lower, upper), lower, upper};
+    }
+    // Returns bounds of the number of elements less than `val`, or less or equal if `orEqual`.
+    // Elements of a bucket are in [start, next start), except the ones out of the range of the
+    // histogram, which are counted in the first and the last buckets.
+    template <typename T>
+    std::pair<ui64, ui64> GetLessBounds(T val, bool orEqual) const {
+        const auto index = Histogram_->FindContainingBucketIndex<T>(val);
+        const ui64 before = index ? GetPrefixSum(index - 1) : 0;
+        const ui64 upTo = GetPrefixSum(index);
+        if (!orEqual && index && CmpEqual<T>(val, Histogram_->template GetBucketStart<T>(index))) {
+            return {before, before};
+        }
+        if constexpr (!std::is_floating_point_v<T>) {
+            if (orEqual && index + 1 < Histogram_->GetNumBuckets() &&
+                static_cast<T>(val + 1) == Histogram_->template GetBucketStart<T>(index + 1)) {
+                return {upTo, upTo};
+            }
+        }
+        return {before, upTo};
+    }
+    void OnLookups(ui64 count) const {
+        if (Y_UNLIKELY(Settings_.Counters)) {
+            Settings_.Counters->OnLookups(count);
+        }
+    }
+
+    // Returns a number of elements in buckets [0, index].
+    ui64 GetPrefixSum(ui32 index) const {
+        if (Settings_.Mode == EMode::Static) {
+            return PrefixSum_[index];
+        }
+        ui64 sum = 0;
+        for (ui32 i = index + 1; i; i &= i - 1) {
+            sum += PrefixSum_[i - 1];
+        }
+        return sum;
+    }
+    // Returns a number of elements in buckets [index, numBuckets).
+    // Derived from the prefix sums to not keep a separate array.
+    ui64 GetSuffixSum(ui32 index) const {
+        return index ? NumElements_ - GetPrefixSum(index - 1) : NumElements_;
     }
+    void UpdateBucket(ui32 index, ui64 count);
+    void RefreshNdv();
 
     void CreatePrefixSum(ui32 numBuckets);
-    void CreateSuffixSum(ui32 numBuckets);
-    std::shared_ptr<TEqWidthHistogram> Histogram_;
-    TVector<ui64> PrefixSum_;
-    TVector<ui64> SuffixSum_;
+    // Keeps the histogram alive if the estimator owns it.
+    std::shared_ptr<TEqWidthHistogram> Owner_;
+    TEqWidthHistogram* Histogram_;
+    TSettings Settings_;
+    // Plain prefix sums for the `Static` mode, a Fenwick tree for the `Incremental` mode.
+    std::pmr::vector<ui64> PrefixSum_;
+    ui64 NumElements_{0};
+    // Estimated distinct counts of the histogram and of its buckets, if they are counted.
+    bool HasNdv_{false};
+    ui64 Ndv_{0};
+    std::pmr::vector<ui64> BucketNdv_;
 };
 } // namespace NKikimr
@@ -0,0 +1,123 @@
+#include "eq_width_histogram_2d.h"
+
+namespace NKikimr {
+
+namespace {
+
+// Returns a histogram with the buckets of the given `histogram` and zero counts.
+TEqWidthHistogram MakeAxis(const TEqWidthHistogram& histogram) {
+    return VisitHistogramValueType(histogram.GetType(), [&histogram](auto tag) {
+        using T = typename decltype(tag)::type;
+        const TVector<ui64> counts(histogram.GetNumBuckets());
+        return TEqWidthHistogram(histogram.GetType(), histogram.GetStarts<T>(), TArrayRef<const ui64>(counts.data(), counts.size()));
+    });
+}
+
+} // namespace
+
+TEqWidthHistogram2D::TEqWidthHistogram2D(const TEqWidthHistogram& xAxis, const TEqWidthHistogram& yAxis)
+    : X_(MakeAxis(xAxis))
+    , Y_(MakeAxis(yAxis))
+    , Counts_(static_cast<size_t>(X_.GetNumBuckets()) * Y_.GetNumBuckets())
+{
+}
+
+// Binary layout:
+// [4 byte: zero marker][1 byte: version]
+// [8 byte: size][x axis in the `V2` format][8 byte: size][y axis in the `V2` format]
+// [varint counts[0][0]... varint counts[nx][ny]].
+TEqWidthHistogram2D::TEqWidthHistogram2D(const char* str, ui64 size) {
+    const char* end = str + size;
+    const char* in = str;
+    const auto read = [&](void* data, ui64 partSize) {
+        Y_ENSURE(partSize <= static_cast<ui64>(end - in), "Truncated histogram");
+        std::memcpy(data, in, partSize);
+        in += partSize;
+    };
+    ui32 marker = 1;
+    ui8 version = 0;
+    read(&marker, sizeof(ui32));
+    Y_ENSURE(marker == HistogramVersionedFormatMarker, "Histogram is not in a versioned format");
+    read(&version, sizeof(ui8));
+    Y_ENSURE(version == static_cast<ui8>(EHistogramFormat::EqWidth2DV1), "Unknown histogram format " << static_cast<ui32>(version));
+    for (auto* axis : {&X_, &Y_}) {
+        ui64 axisSize = 0;
+        read(&axisSize, sizeof(ui64));
+        Y_ENSURE(axisSize <= static_cast<ui64>(end - in), "Truncated histogram");
+        *axis = TEqWidthHistogram(in, axisSize);
+        in += axisSize;
+    }
+    // Every count takes at least a byte, check before allocating.
+    Y_ENSURE(static_cast<ui64>(X_.GetNumBuckets()) * Y_.GetNumBuckets() <= static_cast<ui64>(end - in), "Truncated histogram");
+    Counts_.resize(static_cast<size_t>(X_.GetNumBuckets()) * Y_.GetNumBuckets());
+    for (auto& count : Counts_) {
+        in = NPrivate::ReadVarint(in, end, count);
+    }
+    Y_ENSURE(in == end, "Trailing data after histogram");
+}
+
+template <typename TWrite>
+void TEqWidthHistogram2D::Serialize(TWrite&& write) const {
+    const ui8 version = static_cast<ui8>(EHistogramFormat::EqWidth2DV1);
+    write(&HistogramVersionedFormatMarker, sizeof(ui32));
+    write(&version, sizeof(ui8));
+    for (const auto* axis : {&X_, &Y_}) {
+        TVector<char> data(axis->GetSerializedSize(EHistogramFormat::V2));
+        const ui64 axisSize = axis->SerializeTo(TArrayRef<char>(data.data(), data.size()), EHistogramFormat::V2);
+        write(&axisSize, sizeof(ui64));
+        write(data.data(), axisSize);
+    }
+    // Counts are encoded by chunks to keep the number of writes low.
+    constexpr size_t chunkSize = 256;
+    char chunk[chunkSize * 10];
+    for (size_t i = 0; i < Counts_.size(); i += chunkSize) {
+        const size_t to = std::min(Counts_.size(), i + chunkSize);
+        char* out = chunk;
+        for (size_t j = i; j < to; ++j) {
+            out = NPrivate::WriteVarint(Counts_[j], out);
+        }
+        write(chunk, out - chunk);
+    }
+}
+
+void TEqWidthHistogram2D::SerializeTo(IOutputStream& output) const {
+    Serialize([&output](const void* data, ui64 partSize) {
+        output.Write(data, partSize);
+    });
+}
+
+ui64 TEqWidthHistogram2D::GetSerializedSize() const {
+    ui64 size = 0;
+    Serialize([&size](const void*, ui64 partSize) {
+        size += partSize;
+    });
+    return size;
+}
+
+TEqWidthHistogram2DEstimator::TEqWidthHistogram2DEstimator(std::shared_ptr<TEqWidthHistogram2D> histogram)
+    : TEqWidthHistogram2DEstimator(std::move(histogram), TSettings())
+{
+}
+
+TEqWidthHistogram2DEstimator::TEqWidthHistogram2DEstimator(std::shared_ptr<TEqWidthHistogram2D> histogram, TSettings settings)
+    : Histogram_(std::move(histogram))
+    , Settings_(settings)
+{
+    Refresh();
+}
+
+void TEqWidthHistogram2DEstimator::Refresh() {
+    const ui32 nx = Histogram_->GetXAxis().GetNumBuckets();
+    const ui32 ny = Histogram_->GetYAxis().GetNumBuckets();
+    NumBucketsY_ = ny;
+    PrefixSum_.assign(static_cast<size_t>(nx + 1) * (ny + 1), 0);
+    for (ui32 x = 0; x < nx; ++x) {
+        ui64 row = 0;
+        for (ui32 y = 0; y < ny; ++y) {
+            row += Histogram_->GetNumElementsInBucket(x, y);
+            PrefixSum_[static_cast<size_t>(x + 1) * (ny + 1) + y + 1] = PrefixSum_[static_cast<size_t>(x) * (ny + 1) + y + 1] + row;
+        }
+    }
+}
+
+} // namespace NKikimr
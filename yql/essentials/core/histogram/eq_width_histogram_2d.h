@@ -0,0 +1,198 @@
+#pragma once
+
+#include "eq_width_histogram.h"
+
+namespace NKikimr {
+
+// This class represents a 2-D `Equal-width` histogram over a pair of columns: a grid of buckets,
+// which is the product of the buckets of two axes. The axes are `TEqWidthHistogram`s, so the bucket
+// lookup and the value types are the same as for one column, only their layouts are used.
+// Counts of the grid catch the correlation of columns, which the product of two 1-D selectivities
+// misses.
+class TEqWidthHistogram2D {
+public:
+    // Buckets and value types of the columns are taken from the `xAxis` and the `yAxis`, their
+    // counts are not used.
+    TEqWidthHistogram2D(const TEqWidthHistogram& xAxis, const TEqWidthHistogram& yAxis);
+    // From serialized data in the `EqWidth2DV1` format, throws `yexception` if the data is malformed.
+    TEqWidthHistogram2D(const char* str, ui64 size);
+
+    // Adds the given pair of values.
+    template <typename TX, typename TY>
+    void AddElement(TX x, TY y) {
+        Counts_[GetIndex(X_.FindContainingBucketIndex<TX>(x), Y_.FindContainingBucketIndex<TY>(y))]++;
+    }
+
+    // Adds pairs of values `xs[i]` and `ys[i]`.
+    template <typename TX, typename TY>
+    void AddElements(TArrayRef<const TX> xs, TArrayRef<const TY> ys) {
+        Y_ABORT_UNLESS(xs.size() == ys.size());
+        for (size_t i = 0; i < xs.size(); ++i) {
+            AddElement<TX, TY>(xs[i], ys[i]);
+        }
+    }
+
+    // Adds counts of the `other` histogram, returns false if the axes are different.
+    template <typename TX, typename TY>
+    bool Aggregate(const TEqWidthHistogram2D& other) {
+        if (X_.GetType() != other.X_.GetType() || Y_.GetType() != other.Y_.GetType() ||
+            !X_.BucketsEqual<TX>(other.X_) || !Y_.BucketsEqual<TY>(other.Y_)) {
+            return false;
+        }
+        for (size_t i = 0; i < Counts_.size(); ++i) {
+            Counts_[i] += other.Counts_[i];
+        }
+        return true;
+    }
+
+    const TEqWidthHistogram& GetXAxis() const {
+        return X_;
+    }
+    const TEqWidthHistogram& GetYAxis() const {
+        return Y_;
+    }
+    // Returns a number of elements in the bucket (`xIndex`, `yIndex`).
+    ui64 GetNumElementsInBucket(ui32 xIndex, ui32 yIndex) const {
+        return Counts_[GetIndex(xIndex, yIndex)];
+    }
+
+    // Serializes to the given `output`.
+    void SerializeTo(IOutputStream& output) const;
+    // Returns a size of the binary representation.
+    ui64 GetSerializedSize() const;
+
+private:
+    size_t GetIndex(ui32 xIndex, ui32 yIndex) const {
+        return static_cast<size_t>(xIndex) * Y_.GetNumBuckets() + yIndex;
+    }
+    // Serializes, `write(data, size)` is called for the consecutive parts.
+    template <typename TWrite>
+    void Serialize(TWrite&& write) const;
+
+    TEqWidthHistogram X_;
+    TEqWidthHistogram Y_;
+    // Counts of the grid, row by row of the x axis buckets.
+    TVector<ui64> Counts_;
+};
+
+// This class represents a machinery to estimate a number of pairs in a rectangle.
+// A 2-D prefix sum table is precomputed, so every estimate is O(1) after the bucket lookups.
+class TEqWidthHistogram2DEstimator {
+public:
+    struct TSettings {
+        // Weight the buckets on the borders of a rectangle by their coverage, instead of counting
+        // whole buckets, values are assumed to be uniformly distributed within a bucket.
+        bool Interpolate = false;
+    };
+
+    TEqWidthHistogram2DEstimator(std::shared_ptr<TEqWidthHistogram2D> histogram);
+    TEqWidthHistogram2DEstimator(std::shared_ptr<TEqWidthHistogram2D> histogram, TSettings settings);
+
+    // Returns a number of pairs in the rectangle [xLo, xHi] x [yLo, yHi].
+    template <typename TX, typename TY>
+    ui64 EstimateRange(TX xLo, TX xHi, TY yLo, TY yHi) const {
+        if (CmpLess<TX>(xHi, xLo) || CmpLess<TY>(yHi, yLo)) {
+            return 0;
+        }
+        const auto x = GetAxisRange<TX>(Histogram_->GetXAxis(), xLo, xHi);
+        const auto y = GetAxisRange<TY>(Histogram_->GetYAxis(), yLo, yHi);
+        double sum = 0;
+        for (ui32 i = 0; i < x.NumTerms; ++i) {
+            for (ui32 j = 0; j < y.NumTerms; ++j) {
+                const auto& xTerm = x.Terms[i];
+                const auto& yTerm = y.Terms[j];
+                if (xTerm.Weight && yTerm.Weight) {
+                    sum += xTerm.Weight * yTerm.Weight * GetRectangleSum(xTerm.From, xTerm.To, yTerm.From, yTerm.To);
+                }
+            }
+        }
+        return static_cast<ui64>(std::max(0.0, sum) + 0.5);
+    }
+
+    // Returns a number of pairs equal to (`x`, `y`), assuming all values of a bucket are present.
+    template <typename TX, typename TY>
+    ui64 EstimateEqual(TX x, TY y) const {
+        const auto& xAxis = Histogram_->GetXAxis();
+        const auto& yAxis = Histogram_->GetYAxis();
+        const ui64 count = Histogram_->GetNumElementsInBucket(xAxis.FindContainingBucketIndex<TX>(x), yAxis.FindContainingBucketIndex<TY>(y));
+        // Divided one by one, the product of widths could overflow.
+        return std::max<ui64>(1, count / xAxis.GetBucketWidth<TX>() / yAxis.GetBucketWidth<TY>());
+    }
+
+    // Returns the total number of pairs.
+    ui64 GetNumElements() const {
+        return PrefixSum_.back();
+    }
+
+    // Rebuilds the prefix sums, has to be called if the histogram was changed.
+    void Refresh();
+
+private:
+    // A term of the sum over an axis: buckets [From, To] are counted with the `Weight`.
+    struct TAxisTerm {
+        ui32 From{0};
+        ui32 To{0};
+        double Weight{0};
+    };
+    // The buckets of an axis covered by a range: the whole range of buckets, corrected for the
+    // partially covered first and last buckets if interpolating.
+    struct TAxisRange {
+        TAxisTerm Terms[3];
+        ui32 NumTerms{0};
+    };
+
+    template <typename T>
+    TAxisRange GetAxisRange(const TEqWidthHistogram& axis, T lo, T hi) const {
+        TAxisRange range;
+        const ui32 first = axis.FindContainingBucketIndex<T>(lo);
+        const ui32 last = axis.FindContainingBucketIndex<T>(hi);
+        if (!Settings_.Interpolate) {
+            range.Terms[range.NumTerms++] = {first, last, 1.0};
+            return range;
+        }
+        if (first == last) {
+            range.Terms[range.NumTerms++] = {first, first, GetCoverage<T>(axis, first, lo, hi)};
+            return range;
+        }
+        range.Terms[range.NumTerms++] = {first, last, 1.0};
+        range.Terms[range.NumTerms++] = {first, first, GetCoverage<T>(axis, first, lo, hi) - 1};
+        range.Terms[range.NumTerms++] = {last, last, GetCoverage<T>(axis, last, lo, hi) - 1};
+        return range;
+    }
+
+    // Returns the part of the bucket by the given `index` covered by [lo, hi].
+    template <typename T>
+    static double GetCoverage(const TEqWidthHistogram& axis, ui32 index, T lo, T hi) {
+        const double length = axis.GetBucketLength<T>(index);
+        if (length <= 0) {
+            return 1;
+        }
+        const T start = axis.GetBucketStart<T>(index);
+        if (CmpLess<T>(hi, start)) {
+            // Only values below the first bucket.
+            return 0;
+        }
+        const double from = CmpLess<T>(lo, start) ? 0.0 : static_cast<double>(NPrivate::ValueDiff<T>(lo, start));
+        double to = static_cast<double>(NPrivate::ValueDiff<T>(hi, start));
+        if constexpr (!std::is_floating_point_v<T>) {
+            to += 1;
+        }
+        return std::clamp((std::min(to, length) - from) / length, 0.0, 1.0);
+    }
+
+    // Returns a number of pairs in buckets [xFrom, xTo] x [yFrom, yTo].
+    ui64 GetRectangleSum(ui32 xFrom, ui32 xTo, ui32 yFrom, ui32 yTo) const {
+        return GetPrefixSum(xTo + 1, yTo + 1) - GetPrefixSum(xFrom, yTo + 1) - GetPrefixSum(xTo + 1, yFrom) + GetPrefixSum(xFrom, yFrom);
+    }
+    // Returns a number of pairs in buckets [0, x) x [0, y).
+    ui64 GetPrefixSum(ui32 x, ui32 y) const {
+        return PrefixSum_[static_cast<size_t>(x) * (NumBucketsY_ + 1) + y];
+    }
+
+    std::shared_ptr<TEqWidthHistogram2D> Histogram_;
+    TSettings Settings_;
+    ui32 NumBucketsY_{0};
+    TVector<ui64> PrefixSum_;
+};
+
+} // namespace NKikimr
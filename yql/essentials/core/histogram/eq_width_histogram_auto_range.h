@@ -0,0 +1,169 @@
+#pragma once
+
+#include "eq_width_histogram.h"
+
+namespace NKikimr {
+
+// Builds an `Equal-width` histogram without a caller provided range, in two phases:
+// 1. The range of values is observed, from the values themselves or from block level min/max,
+//    e.g. from metadata of column shard portions, so there is no extra pass over the data.
+// 2. Values are added. The layout is built on the first added value: the number of buckets is the
+//    largest one fitting `memoryBudget` bytes, at most `maxBuckets`. A range too narrow for that
+//    number of buckets, e.g. of a single value, is widened to the minimum width, see
+//    `GetMinWidthRange()`. Values out of the observed range grow the range, see
+//    `TEqWidthHistogram::AddElementAdaptive()`. If no range is observed, the range of the first
+//    added values is taken.
+// NaN values are not observed.
+template <typename T>
+class TAutoRangeEqWidthHistogramBuilder {
+public:
+    static constexpr ui32 DefaultMaxBuckets = 256;
+
+    explicit TAutoRangeEqWidthHistogramBuilder(ui64 memoryBudget, ui32 maxBuckets = DefaultMaxBuckets,
+                                               EHistogramValueType type = GetHistogramValueType<T>())
+        : NumBuckets_(std::min(GetNumBucketsForBudget(memoryBudget), std::max(maxBuckets, 1U)))
+        , Type_(type)
+    {
+        Y_ABORT_UNLESS(sizeof(T) == GetHistogramValueTypeSize(type));
+    }
+
+    // Returns the number of buckets of a histogram of `T` which takes at most `memoryBudget` bytes,
+    // at least one.
+    static ui32 GetNumBucketsForBudget(ui64 memoryBudget) {
+        constexpr ui64 bucketSize = sizeof(ui64) + sizeof(T);
+        const ui64 budget = memoryBudget > sizeof(TEqWidthHistogram) ? memoryBudget - sizeof(TEqWidthHistogram) : 0;
+        return static_cast<ui32>(std::clamp<ui64>(budget / bucketSize, 1, std::numeric_limits<ui32>::max()));
+    }
+
+    // The first phase, observes values in range [min, max].
+    void ObserveRange(T min, T max) {
+        // The layout is built already.
+        Y_ABORT_UNLESS(!Histogram_);
+        if constexpr (std::is_floating_point_v<T>) {
+            if (std::isnan(min) || std::isnan(max)) {
+                return;
+            }
+        }
+        if (!HasRange_) {
+            Min_ = min;
+            Max_ = max;
+            HasRange_ = true;
+            return;
+        }
+        if (CmpLess<T>(min, Min_)) {
+            Min_ = min;
+        }
+        if (CmpLess<T>(Max_, max)) {
+            Max_ = max;
+        }
+    }
+    void ObserveElements(TArrayRef<const T> values) {
+        for (const auto& val : values) {
+            ObserveRange(val, val);
+        }
+    }
+
+    // The second phase, adds values.
+    void AddElement(T val) {
+        if (!Histogram_ && !HasRange_) {
+            ObserveRange(val, val);
+        }
+        GetHistogram().template AddElementAdaptive<T>(val);
+    }
+    void AddElements(TArrayRef<const T> values) {
+        if (!Histogram_ && !HasRange_) {
+            ObserveElements(values);
+        }
+        GetHistogram().template AddElementsAdaptive<T>(values);
+    }
+
+    // Returns the built histogram, a histogram of the observed range with zero counts if no values
+    // are added.
+    TEqWidthHistogram Finish() {
+        return std::move(GetHistogram());
+    }
+
+    bool HasRange() const {
+        return HasRange_;
+    }
+    ui32 GetMaxNumBuckets() const {
+        return NumBuckets_;
+    }
+
+private:
+    TEqWidthHistogram& GetHistogram() {
+        if (!Histogram_) {
+            TVector<T> starts{T()};
+            if (HasRange_) {
+                const auto [min, max] = GetMinWidthRange(Min_, Max_, NumBuckets_);
+                starts = NPrivate::MakeEqWidthStarts<T>(min, max, NumBuckets_);
+            }
+            const TVector<ui64> counts(starts.size());
+            Histogram_.emplace(Type_, TArrayRef<const T>(starts.data(), starts.size()), TArrayRef<const ui64>(counts.data(), counts.size()));
+        }
+        return *Histogram_;
+    }
+
+    // Minimum widths of floating point buckets, see `GetMinWidthRange()`.
+    static constexpr double MinRelativeWidth = 1.0 / (1 << 20);
+    static constexpr double MinAbsoluteWidth = 1.0 / (1 << 20);
+
+    // Returns the range [min, max] widened so that it has `numBuckets` equal-width buckets.
+    // For integers the range has at least one value per bucket, it is [min, min + numBuckets - 1]
+    // unless that overflows `T`, then it is shifted down. Only a type with fewer values than
+    // buckets gets fewer buckets. For floating point types the width of a bucket is a power of two
+    // at least `MinRelativeWidth` of the magnitude of values and at least `MinAbsoluteWidth`, so
+    // a range of a single value, e.g. zero, grows to the following distinct values in a few rounds
+    // of doubling. The width is at least the distance between adjacent representable values,
+    // starts are aligned to it, so they are exact. If such a range overflows `T`, the range is not
+    // widened.
+    static std::pair<T, T> GetMinWidthRange(T min, T max, ui32 numBuckets) {
+        if constexpr (std::is_floating_point_v<T>) {
+            // The distance between the adjacent values above `val` by the magnitude.
+            const auto getStep = [](T val) {
+                const T abs = std::fabs(val);
+                return static_cast<double>(std::nextafter(abs, std::numeric_limits<T>::infinity())) - abs;
+            };
+            const double magnitude = std::max<double>(std::fabs(min), std::fabs(max));
+            const double minWidth = std::max(magnitude * MinRelativeWidth, MinAbsoluteWidth);
+            // The least power of two not less than `minWidth`.
+            double width = std::ldexp(1.0, std::ilogb(minWidth));
+            if (width < minWidth) {
+                width *= 2;
+            }
+            width = std::max(width, getStep(min));
+            for (double step = getStep(min + numBuckets * width); step > width; step = getStep(min + numBuckets * width)) {
+                width = step;
+            }
+            if (!std::isfinite(width) || NPrivate::ValueDiff<T>(max, min) >= numBuckets * width) {
+                return {min, max};
+            }
+            const double start = std::floor(min / width) * width;
+            const double end = start + numBuckets * width;
+            if (end > std::numeric_limits<T>::max()) {
+                return {min, max};
+            }
+            return {static_cast<T>(start), static_cast<T>(end)};
+        } else {
+            const ui64 need = numBuckets - 1;
+            if (NPrivate::ValueDiff<T>(max, min) >= need) {
+                return {min, max};
+            }
+            const ui64 up = NPrivate::ValueDiff<T>(std::numeric_limits<T>::max(), min);
+            if (up >= need) {
+                return {min, static_cast<T>(static_cast<ui64>(min) + need)};
+            }
+            const ui64 down = std::min(need - up, NPrivate::ValueDiff<T>(min, std::numeric_limits<T>::min()));
+            return {static_cast<T>(static_cast<ui64>(min) - down), std::numeric_limits<T>::max()};
+        }
+    }
+
+    ui32 NumBuckets_;
+    EHistogramValueType Type_;
+    bool HasRange_{false};
+    T Min_{};
+    T Max_{};
+    std::optional<TEqWidthHistogram> Histogram_;
+};
+
+} // namespace NKikimr
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "eq_width_histogram.h"
+
+#include <util/thread/pool.h>
+
+#include <atomic>
+#include <exception>
+#include <latch>
+
+namespace NKikimr {
+
+namespace NPrivate {
+
+// The pool which runs a task of `RunInParallel()` on this thread, if any.
+inline thread_local const IThreadPool* RunInParallelPool = nullptr;
+
+// Runs `task(i)` for every i in [0, numTasks) on the `pool` and waits for all of them.
+// If tasks throw, or a task can not be added to the `pool`, the first exception is rethrown after
+// all the added tasks are finished, so tasks never outlive the caller's state.
+// Tasks which call it again with the same `pool` run the nested tasks inline, waiting for them
+// on a worker could deadlock the pool. Other work on the `pool` must not call it with that `pool`.
+template <typename TTask>
+void RunInParallel(IThreadPool& pool, ui32 numTasks, TTask&& task) {
+    if (RunInParallelPool == &pool) {
+        for (ui32 i = 0; i < numTasks; ++i) {
+            task(i);
+        }
+        return;
+    }
+    std::latch done(numTasks);
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    ui32 numAdded = 0;
+    try {
+        for (; numAdded < numTasks; ++numAdded) {
+            pool.SafeAddFunc([&pool, &task, &done, &failed, &error, i = numAdded]() {
+                RunInParallelPool = &pool;
+                try {
+                    task(i);
+                } catch (...) {
+                    // Published to the waiting thread by the latch.
+                    if (!failed.exchange(true)) {
+                        error = std::current_exception();
+                    }
+                }
+                RunInParallelPool = nullptr;
+                done.count_down();
+            });
+        }
+    } catch (...) {
+        done.count_down(numTasks - numAdded);
+        done.wait();
+        throw;
+    }
+    done.wait();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace NPrivate
+
+// Builds a histogram from the given `values` in parallel on the caller provided `pool`.
+// The values are split into `numParts` contiguous parts, every part is counted into a thread local
+// partial histogram with the same bucket layout as `layout`, and the partials are merged by a
+// reduction tree, every level of the tree is merged in parallel as well.
+// The returned histogram has the layout and the counts of `layout` plus counts of `values`.
+template <typename T>
+TEqWidthHistogram BuildEqWidthHistogramParallel(const TEqWidthHistogram& layout, TArrayRef<const T> values,
+                                                IThreadPool& pool, ui32 numParts) {
+    // Parts smaller than that are not worth a task.
+    constexpr ui64 minPartSize = 64 * 1024;
+    const ui64 maxParts = std::max<ui64>(1, (values.size() + minPartSize - 1) / minPartSize);
+    numParts = static_cast<ui32>(std::clamp<ui64>(numParts, 1, maxParts));
+    if (numParts == 1) {
+        TEqWidthHistogram result(layout);
+        result.AddElements<T>(values);
+        return result;
+    }
+
+    const ui64 partSize = (values.size() + numParts - 1) / numParts;
+    TVector<TEqWidthHistogram> partials(numParts, layout);
+    NPrivate::RunInParallel(pool, numParts, [&](ui32 part) {
+        const ui64 from = std::min<ui64>(values.size(), part * partSize);
+        const ui64 to = std::min<ui64>(values.size(), from + partSize);
+        // Counts of `layout` must be taken into account only once.
+        if (part) {
+            partials[part].ResetCounts();
+        }
+        partials[part].AddElements<T>(values.subspan(from, to - from));
+    });
+
+    for (ui32 stride = 1; stride < numParts; stride *= 2) {
+        const ui32 numMerges = (numParts - stride + 2 * stride - 1) / (2 * stride);
+        NPrivate::RunInParallel(pool, numMerges, [&](ui32 merge) {
+            const ui32 left = merge * 2 * stride;
+            partials[left].Aggregate<T>(partials[left + stride]);
+        });
+    }
+    return std::move(partials.front());
+}
+
+} // namespace NKikimr
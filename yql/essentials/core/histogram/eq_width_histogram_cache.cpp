@@ -0,0 +1,122 @@
+#include "eq_width_histogram_cache.h"
+
+#include <util/generic/singleton.h>
+
+namespace NKikimr {
+
+TEqWidthHistogramEstimatorCache::TEqWidthHistogramEstimatorCache(ui64 maxSize, ui32 numShards)
+    : MaxShardSize_(maxSize / std::max(numShards, 1U))
+    , Shards_(std::max(numShards, 1U))
+{
+}
+
+TEqWidthHistogramEstimatorCache& TEqWidthHistogramEstimatorCache::Instance() {
+    return *Singleton<TEqWidthHistogramEstimatorCache>();
+}
+
+TEqWidthHistogramEstimatorCache::TEstimatorPtr TEqWidthHistogramEstimatorCache::Find(TStringBuf table, TStringBuf column,
+                                                                                    ui64 version) {
+    const TKey key{table, column};
+    auto& shard = GetShard(key);
+    TReadGuard guard(shard.Lock);
+    const auto it = shard.Index.find(key);
+    if (it == shard.Index.end() || it->second->Version != version) {
+        return nullptr;
+    }
+    auto& entry = *it->second;
+    if (!entry.Used.load(std::memory_order_relaxed)) {
+        entry.Used.store(true, std::memory_order_relaxed);
+    }
+    return entry.Estimator;
+}
+
+TEqWidthHistogramEstimatorCache::TEstimatorPtr TEqWidthHistogramEstimatorCache::Insert(TStringBuf table, TStringBuf column,
+                                                                                      ui64 version, TEstimatorPtr estimator) {
+    Y_ABORT_UNLESS(estimator);
+    const TKey key{table, column};
+    auto& shard = GetShard(key);
+    const ui64 size = estimator->GetAllocatedSize();
+    TWriteGuard guard(shard.Lock);
+    if (const auto it = shard.Index.find(key); it != shard.Index.end()) {
+        auto& entry = *it->second;
+        if (entry.Version >= version) {
+            // A newer version, or the same one created concurrently: keep the cached one.
+            entry.Used.store(true, std::memory_order_relaxed);
+            return entry.Estimator;
+        }
+        shard.Entries.splice(shard.Entries.begin(), shard.Entries, it->second);
+        shard.Size -= entry.Size;
+        entry.Version = version;
+        entry.Estimator = estimator;
+        entry.Size = size;
+        entry.Used.store(false, std::memory_order_relaxed);
+        shard.Size += size;
+    } else {
+        auto& entry = shard.Entries.emplace_front();
+        entry.Table = table;
+        entry.Column = column;
+        entry.Version = version;
+        entry.Estimator = estimator;
+        entry.Size = size;
+        shard.Index.emplace(entry.GetKey(), shard.Entries.begin());
+        shard.Size += size;
+    }
+    Evict(shard, shard.Entries.begin());
+    return estimator;
+}
+
+void TEqWidthHistogramEstimatorCache::Invalidate(TStringBuf table, TStringBuf column) {
+    const TKey key{table, column};
+    auto& shard = GetShard(key);
+    TWriteGuard guard(shard.Lock);
+    if (const auto it = shard.Index.find(key); it != shard.Index.end()) {
+        const auto entry = it->second;
+        shard.Size -= entry->Size;
+        shard.Index.erase(it);
+        shard.Entries.erase(entry);
+    }
+}
+
+void TEqWidthHistogramEstimatorCache::Clear() {
+    for (auto& shard : Shards_) {
+        TWriteGuard guard(shard.Lock);
+        shard.Index.clear();
+        shard.Entries.clear();
+        shard.Size = 0;
+    }
+}
+
+ui64 TEqWidthHistogramEstimatorCache::GetSize() const {
+    ui64 size = 0;
+    for (const auto& shard : Shards_) {
+        TReadGuard guard(shard.Lock);
+        size += shard.Size;
+    }
+    return size;
+}
+
+ui64 TEqWidthHistogramEstimatorCache::GetNumEntries() const {
+    ui64 numEntries = 0;
+    for (const auto& shard : Shards_) {
+        TReadGuard guard(shard.Lock);
+        numEntries += shard.Index.size();
+    }
+    return numEntries;
+}
+
+void TEqWidthHistogramEstimatorCache::Evict(TShard& shard, std::list<TEntry>::iterator keep) {
+    // Every used entry is moved to the front at most once, and the kept one only after all others
+    // were passed, so the loop ends.
+    while (shard.Size > MaxShardSize_ && shard.Entries.size() > 1) {
+        const auto last = std::prev(shard.Entries.end());
+        if (last == keep || last->Used.exchange(false, std::memory_order_relaxed)) {
+            shard.Entries.splice(shard.Entries.begin(), shard.Entries, last);
+            continue;
+        }
+        shard.Size -= last->Size;
+        shard.Index.erase(last->GetKey());
+        shard.Entries.erase(last);
+    }
+}
+
+} // namespace NKikimr
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "eq_width_histogram.h"
+
+#include <util/generic/hash.h>
+#include <util/generic/string.h>
+#include <util/system/rwlock.h>
+
+#include <atomic>
+#include <list>
+
+namespace NKikimr {
+
+// This class represents a cache of ready to use estimators keyed by a table and a column, so the
+// same statistics are not deserialized and prefix sums are not recomputed on every planning.
+// Every entry is tagged with a version of statistics: a lookup of a newer version misses and an
+// older entry is replaced by an insert of a newer one. Entries are evicted in the approximate LRU
+// order of the CLOCK algorithm when the total `GetAllocatedSize()` of estimators exceeds `maxSize`
+// bytes: a lookup only marks the entry as used, and a used entry gets a second chance on eviction.
+// Keys are spread over shards with a read-write lock each, lookups do not allocate and share the lock.
+// Estimators are shared, an evicted estimator stays valid while it is borrowed.
+class TEqWidthHistogramEstimatorCache {
+public:
+    using TEstimatorPtr = std::shared_ptr<const TEqWidthHistogramEstimator>;
+
+    static constexpr ui64 DefaultMaxSize = 256ULL << 20;
+    static constexpr ui32 DefaultNumShards = 16;
+
+    explicit TEqWidthHistogramEstimatorCache(ui64 maxSize = DefaultMaxSize, ui32 numShards = DefaultNumShards);
+
+    // Returns the process wide cache.
+    static TEqWidthHistogramEstimatorCache& Instance();
+
+    // Returns the cached estimator of the given `version`, nullptr if it is not cached.
+    TEstimatorPtr Find(TStringBuf table, TStringBuf column, ui64 version);
+    // Caches the `estimator` of the given `version` unless this or a newer version is cached already.
+    // Returns the cached estimator, which is the newer one in that case.
+    TEstimatorPtr Insert(TStringBuf table, TStringBuf column, ui64 version, TEstimatorPtr estimator);
+    // Returns the cached estimator of the given `version` or caches the one returned by `create()`.
+    // The estimator is created without a lock, concurrent misses may create it more than once.
+    template <typename TCreate>
+    TEstimatorPtr FindOrCreate(TStringBuf table, TStringBuf column, ui64 version, TCreate&& create) {
+        if (auto estimator = Find(table, column, version)) {
+            return estimator;
+        }
+        return Insert(table, column, version, create());
+    }
+
+    // Removes the entry of the given column, of any version.
+    void Invalidate(TStringBuf table, TStringBuf column);
+    void Clear();
+
+    // Returns the total size of cached estimators in bytes.
+    ui64 GetSize() const;
+    ui64 GetNumEntries() const;
+    ui64 GetMaxSize() const {
+        return MaxShardSize_ * Shards_.size();
+    }
+
+private:
+    // A key of the index, refers to the strings of an entry or to the arguments of a lookup.
+    struct TKey {
+        TStringBuf Table;
+        TStringBuf Column;
+
+        bool operator==(const TKey& other) const {
+            return Table == other.Table && Column == other.Column;
+        }
+    };
+
+    struct TKeyHash {
+        size_t operator()(const TKey& key) const {
+            const size_t hash = THash<TStringBuf>()(key.Table);
+            return hash ^ (THash<TStringBuf>()(key.Column) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2));
+        }
+    };
+
+    struct TEntry {
+        TString Table;
+        TString Column;
+        ui64 Version{0};
+        TEstimatorPtr Estimator;
+        ui64 Size{0};
+        // Set by lookups under the read lock, cleared by the eviction.
+        std::atomic<bool> Used{false};
+
+        TKey GetKey() const {
+            return {Table, Column};
+        }
+    };
+
+    struct TShard {
+        mutable TRWMutex Lock;
+        // Entries in the order of inserts, the newest first. Entries used since they were passed by
+        // the eviction are moved to the front instead of being evicted.
+        std::list<TEntry> Entries;
+        THashMap<TKey, std::list<TEntry>::iterator, TKeyHash> Index;
+        ui64 Size{0};
+    };
+
+    TShard& GetShard(const TKey& key) {
+        return Shards_[TKeyHash()(key) % Shards_.size()];
+    }
+    // Evicts entries from the back of the `shard` until it fits the budget, see `TEntry::Used`.
+    // The `keep` entry is kept even if it does not fit alone.
+    void Evict(TShard& shard, std::list<TEntry>::iterator keep);
+
+    ui64 MaxShardSize_;
+    TVector<TShard> Shards_;
+};
+
+} // namespace NKikimr
@@ -0,0 +1,164 @@
+#include "eq_width_histogram_compact.h"
+
+namespace NKikimr {
+
+namespace {
+
+// Returns the smallest size of a count which fits the given `count`.
+ui8 GetFittingCountSize(ui64 count) {
+    if (count <= std::numeric_limits<ui16>::max()) {
+        return sizeof(ui16);
+    }
+    if (count <= std::numeric_limits<ui32>::max()) {
+        return sizeof(ui32);
+    }
+    return sizeof(ui64);
+}
+
+ui64 GetStorageSize(ui64 numBytes) {
+    return (numBytes + sizeof(ui64) - 1) / sizeof(ui64);
+}
+
+} // namespace
+
+TCompactEqWidthHistogram::TCompactEqWidthHistogram(const TEqWidthHistogram& histogram)
+    : ValueType_(histogram.GetType())
+{
+    Y_ABORT_UNLESS(ValueType_ != EHistogramValueType::NotSupported);
+    const auto counts = histogram.GetCounts();
+    AllocateBuckets(histogram.GetNumBuckets(), GetFittingCountSize(*std::max_element(counts.begin(), counts.end())));
+    VisitHistogramValueType(ValueType_, [&](auto tag) {
+        using T = typename decltype(tag)::type;
+        const auto starts = histogram.GetStarts<T>();
+        std::copy(starts.begin(), starts.end(), reinterpret_cast<T*>(StartsStorage_.data()));
+    });
+    for (ui32 i = 0; i < NumBuckets_; ++i) {
+        AddToBucket(i, counts[i]);
+    }
+}
+
+// Binary layout:
+// [4 byte: zero marker][1 byte: version][1 byte: value type][1 byte: flags][1 byte: count size]
+// [4 byte: number of buckets][value size * n: starts][count size * n: counts].
+TCompactEqWidthHistogram::TCompactEqWidthHistogram(const char* str, ui64 size) {
+    const char* end = str + size;
+    const char* in = str;
+    const auto read = [&](void* data, ui64 partSize) {
+        Y_ENSURE(partSize <= static_cast<ui64>(end - in), "Truncated histogram");
+        std::memcpy(data, in, partSize);
+        in += partSize;
+    };
+    ui32 marker = 1;
+    ui8 version = 0;
+    ui8 flags = 0;
+    ui8 countSize = 0;
+    ui32 numBuckets = 0;
+    read(&marker, sizeof(ui32));
+    Y_ENSURE(marker == HistogramVersionedFormatMarker, "Histogram is not in a versioned format");
+    read(&version, sizeof(ui8));
+    Y_ENSURE(version == static_cast<ui8>(EHistogramFormat::CompactV1), "Unknown histogram format " << static_cast<ui32>(version));
+    read(&ValueType_, sizeof(EHistogramValueType));
+    Y_ENSURE(IsValidHistogramValueType(ValueType_) && ValueType_ != EHistogramValueType::NotSupported,
+             "Unknown histogram value type " << static_cast<ui32>(ValueType_));
+    read(&flags, sizeof(ui8));
+    read(&countSize, sizeof(ui8));
+    Y_ENSURE(countSize == sizeof(ui16) || countSize == sizeof(ui32) || countSize == sizeof(ui64), "Malformed histogram count size");
+    read(&numBuckets, sizeof(ui32));
+    // Check before allocating.
+    Y_ENSURE(numBuckets >= 1 && numBuckets <= static_cast<ui64>(end - in) / (GetHistogramValueTypeSize(ValueType_) + countSize),
+             "Malformed number of histogram buckets");
+    AllocateBuckets(numBuckets, countSize);
+    read(StartsStorage_.data(), static_cast<ui64>(GetHistogramValueTypeSize(ValueType_)) * numBuckets);
+    read(CountsStorage_.data(), static_cast<ui64>(countSize) * numBuckets);
+    Y_ENSURE(in == end, "Trailing data after histogram");
+}
+
+TEqWidthHistogram TCompactEqWidthHistogram::ToHistogram(std::pmr::memory_resource* resource) const {
+    TVector<ui64> counts(NumBuckets_);
+    for (ui32 i = 0; i < NumBuckets_; ++i) {
+        counts[i] = GetNumElementsInBucket(i);
+    }
+    return VisitHistogramValueType(ValueType_, [&](auto tag) {
+        using T = typename decltype(tag)::type;
+        return TEqWidthHistogram(ValueType_, TArrayRef<const T>(StartsData<T>(), NumBuckets_),
+                                 TArrayRef<const ui64>(counts.data(), counts.size()), resource);
+    });
+}
+
+void TCompactEqWidthHistogram::AddToBucket(ui32 index, ui64 count) {
+    const ui64 current = GetNumElementsInBucket(index);
+    Y_ABORT_UNLESS(current <= std::numeric_limits<ui64>::max() - count);
+    const ui64 next = current + count;
+    if (GetFittingCountSize(next) > CountSize_) {
+        SetCountSize(GetFittingCountSize(next));
+    }
+    switch (CountSize_) {
+        case sizeof(ui16):
+            CountsData<ui16>()[index] = next;
+            break;
+        case sizeof(ui32):
+            CountsData<ui32>()[index] = next;
+            break;
+        default:
+            CountsData<ui64>()[index] = next;
+    }
+}
+
+void TCompactEqWidthHistogram::AllocateBuckets(ui32 numBuckets, ui8 countSize) {
+    NumBuckets_ = numBuckets;
+    CountSize_ = countSize;
+    StartsStorage_.assign(GetStorageSize(static_cast<ui64>(numBuckets) * GetHistogramValueTypeSize(ValueType_)), 0);
+    CountsStorage_.assign(GetStorageSize(static_cast<ui64>(numBuckets) * countSize), 0);
+}
+
+void TCompactEqWidthHistogram::SetCountSize(ui8 countSize) {
+    TVector<ui64> counts(NumBuckets_);
+    for (ui32 i = 0; i < NumBuckets_; ++i) {
+        counts[i] = GetNumElementsInBucket(i);
+    }
+    CountSize_ = countSize;
+    CountsStorage_.assign(GetStorageSize(static_cast<ui64>(NumBuckets_) * countSize), 0);
+    // Counts fit the new size, it is never decreased.
+    for (ui32 i = 0; i < NumBuckets_; ++i) {
+        switch (CountSize_) {
+            case sizeof(ui16):
+                CountsData<ui16>()[i] = counts[i];
+                break;
+            case sizeof(ui32):
+                CountsData<ui32>()[i] = counts[i];
+                break;
+            default:
+                CountsData<ui64>()[i] = counts[i];
+        }
+    }
+}
+
+template <typename TWrite>
+void TCompactEqWidthHistogram::Serialize(TWrite&& write) const {
+    const ui8 version = static_cast<ui8>(EHistogramFormat::CompactV1);
+    const ui8 flags = 0;
+    write(&HistogramVersionedFormatMarker, sizeof(ui32));
+    write(&version, sizeof(ui8));
+    write(&ValueType_, sizeof(EHistogramValueType));
+    write(&flags, sizeof(ui8));
+    write(&CountSize_, sizeof(ui8));
+    write(&NumBuckets_, sizeof(ui32));
+    write(StartsStorage_.data(), static_cast<ui64>(GetHistogramValueTypeSize(ValueType_)) * NumBuckets_);
+    write(CountsStorage_.data(), static_cast<ui64>(CountSize_) * NumBuckets_);
+}
+
+void TCompactEqWidthHistogram::SerializeTo(IOutputStream& output) const {
+    Serialize([&output](const void* data, ui64 partSize) {
+        output.Write(data, partSize);
+    });
+}
+
+ui64 TCompactEqWidthHistogram::GetSerializedSize() const {
+    ui64 size = 0;
+    Serialize([&size](const void*, ui64 partSize) {
+        size += partSize;
+    });
+    return size;
+}
+
+} // namespace NKikimr
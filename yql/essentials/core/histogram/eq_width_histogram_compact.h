@@ -0,0 +1,103 @@
+#pragma once
+
+#include "eq_width_histogram.h"
+
+namespace NKikimr {
+
+// This class is only a storage and serialization format of an `Equal-width` histogram, for statistics
+// which are kept resident, e.g. of all tables on a compile node. It does not estimate anything.
+// To estimate, convert it by `ToHistogram()`, which allocates `ui64` counts, and build
+// a `TEqWidthHistogramEstimator` from the result. Hot columns are expected to be cached, see
+// `TEqWidthHistogramEstimatorCache`.
+// Only counts are narrower than in `TEqWidthHistogram`: they take 2, 4 or 8 bytes, the smallest size
+// fitting the maximal count, and the size is promoted when an added count does not fit. Starts are
+// stored as in `TEqWidthHistogram`. The same layout is used in the serialized `CompactV1` format.
+// Distinct count sketches are not kept.
+class TCompactEqWidthHistogram {
+public:
+    explicit TCompactEqWidthHistogram(const TEqWidthHistogram& histogram);
+    // From serialized data in the `EHistogramFormat::CompactV1` format, throws `yexception` if the
+    // data is malformed.
+    TCompactEqWidthHistogram(const char* str, ui64 size);
+
+    // Returns the histogram with `ui64` counts.
+    TEqWidthHistogram ToHistogram(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+
+    // Adds the given `val` to a histogram, returns the index of the bucket it is counted in, the
+    // same as `TEqWidthHistogram::AddElement()`.
+    template <typename T>
+    ui32 AddElement(T val) {
+        const T* starts = StartsData<T>();
+        const T* it = std::upper_bound(starts, starts + NumBuckets_, val, CmpLess<T>);
+        const ui32 index = it == starts ? 0 : it - starts - 1;
+        AddToBucket(index, 1);
+        return index;
+    }
+    // Adds `count` elements to the bucket by the given `index`, promotes the count size if needed.
+    void AddToBucket(ui32 index, ui64 count);
+
+    ui64 GetNumElementsInBucket(ui32 index) const {
+        switch (CountSize_) {
+            case sizeof(ui16):
+                return CountsData<ui16>()[index];
+            case sizeof(ui32):
+                return CountsData<ui32>()[index];
+            default:
+                return CountsData<ui64>()[index];
+        }
+    }
+    template <typename T>
+    T GetBucketStart(ui32 index) const {
+        return StartsData<T>()[index];
+    }
+    ui32 GetNumBuckets() const {
+        return NumBuckets_;
+    }
+    EHistogramValueType GetType() const {
+        return ValueType_;
+    }
+    // Returns the size of a count in bytes: 2, 4 or 8.
+    ui32 GetCountSize() const {
+        return CountSize_;
+    }
+    // Returns a number of bytes allocated by the histogram, including the object itself.
+    ui64 GetAllocatedSize() const {
+        return sizeof(*this) + (StartsStorage_.capacity() + CountsStorage_.capacity()) * sizeof(ui64);
+    }
+
+    // Serializes to the given `output` in the `EHistogramFormat::CompactV1` format.
+    void SerializeTo(IOutputStream& output) const;
+    // Returns a size of the binary representation.
+    ui64 GetSerializedSize() const;
+
+private:
+    template <typename T>
+    const T* StartsData() const {
+        Y_ASSERT(sizeof(T) == GetHistogramValueTypeSize(ValueType_));
+        return reinterpret_cast<const T*>(StartsStorage_.data());
+    }
+    template <typename T>
+    const T* CountsData() const {
+        Y_ASSERT(sizeof(T) == CountSize_);
+        return reinterpret_cast<const T*>(CountsStorage_.data());
+    }
+    template <typename T>
+    T* CountsData() {
+        Y_ASSERT(sizeof(T) == CountSize_);
+        return reinterpret_cast<T*>(CountsStorage_.data());
+    }
+    void AllocateBuckets(ui32 numBuckets, ui8 countSize);
+    // Converts counts to `countSize` bytes each.
+    void SetCountSize(ui8 countSize);
+    template <typename TWrite>
+    void Serialize(TWrite&& write) const;
+
+    EHistogramValueType ValueType_;
+    ui32 NumBuckets_{0};
+    ui8 CountSize_{sizeof(ui16)};
+    // `ui64` elements keep the arrays aligned for any value and count type.
+    TVector<ui64> StartsStorage_;
+    TVector<ui64> CountsStorage_;
+};
+
+} // namespace NKikimr
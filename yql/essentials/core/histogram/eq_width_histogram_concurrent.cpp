@@ -0,0 +1,72 @@
+#include "eq_width_histogram_concurrent.h"
+
+namespace NKikimr {
+
+namespace {
+
+// Returns an index assigned to the current thread, spreads threads over stripes.
+ui32 GetThreadStripeIndex() {
+    static std::atomic<ui32> nextIndex{0};
+    thread_local const ui32 index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+} // namespace
+
+TConcurrentEqWidthHistogram::TConcurrentEqWidthHistogram(const TEqWidthHistogram& histogram, ui32 numStripes)
+    : Layout_(histogram)
+    , NumStripes_(std::max(numStripes, 1U))
+    , StripeSize_((histogram.GetNumBuckets() + CountersPerCacheLine - 1) / CountersPerCacheLine)
+    , Counts_(new TCacheLine[static_cast<ui64>(NumStripes_) * StripeSize_])
+{
+    Y_ABORT_UNLESS(reinterpret_cast<uintptr_t>(Counts_.get()) % alignof(TCacheLine) == 0);
+    Layout_.ResetCounts();
+    // Distinct values are not counted concurrently, snapshots have no distinct counts.
+    Layout_.DisableNdv();
+    for (ui64 i = 0; i < static_cast<ui64>(NumStripes_) * StripeSize_; ++i) {
+        for (auto& counter : Counts_[i].Counters) {
+            counter.store(0, std::memory_order_relaxed);
+        }
+    }
+    for (ui32 i = 0; i < histogram.GetNumBuckets(); ++i) {
+        GetCounter(Counts_.get(), i).store(histogram.GetNumElementsInBucket(i), std::memory_order_relaxed);
+    }
+}
+
+TConcurrentEqWidthHistogram::TCacheLine* TConcurrentEqWidthHistogram::GetStripe() {
+    if (NumStripes_ == 1) {
+        return Counts_.get();
+    }
+    return Counts_.get() + static_cast<ui64>(GetThreadStripeIndex() % NumStripes_) * StripeSize_;
+}
+
+TConcurrentEqWidthHistogram::TLocalCounts& TConcurrentEqWidthHistogram::GetLocalCounts(ui32 numBuckets) {
+    // Shared by all histograms, a thread adds values to one of them at a time.
+    thread_local TLocalCounts local;
+    if (local.Counts.size() < numBuckets) {
+        local.Counts.resize(numBuckets);
+    }
+    return local;
+}
+
+void TConcurrentEqWidthHistogram::FlushLocalCounts(TLocalCounts& local) {
+    auto* stripe = GetStripe();
+    for (const auto index : local.Touched) {
+        GetCounter(stripe, index).fetch_add(local.Counts[index], std::memory_order_relaxed);
+        local.Counts[index] = 0;
+    }
+    local.Touched.clear();
+}
+
+TEqWidthHistogram TConcurrentEqWidthHistogram::Snapshot() const {
+    TEqWidthHistogram snapshot(Layout_);
+    for (ui32 stripe = 0; stripe < NumStripes_; ++stripe) {
+        const auto* counts = Counts_.get() + static_cast<ui64>(stripe) * StripeSize_;
+        for (ui32 i = 0; i < GetNumBuckets(); ++i) {
+            snapshot.AddToBucket(i, GetCounter(counts, i).load(std::memory_order_relaxed));
+        }
+    }
+    return snapshot;
+}
+
+} // namespace NKikimr
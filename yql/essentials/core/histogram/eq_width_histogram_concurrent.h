@@ -0,0 +1,86 @@
+#pragma once
+
+#include "eq_width_histogram.h"
+
+#include <atomic>
+
+namespace NKikimr {
+
+// This class represents an `Equal-width` histogram which many threads could add values to
+// concurrently without a lock, while other threads take snapshots for estimation.
+// Counts are relaxed atomics. With `numStripes` > 1 every bucket has a counter per stripe, writer
+// threads are spread over stripes, so the threads adding values to the same hot bucket do not
+// contend on one cache line. Stripes are folded on read. Distinct values are not counted.
+class TConcurrentEqWidthHistogram {
+public:
+    // The bucket layout and the initial counts are taken from the given `histogram`.
+    explicit TConcurrentEqWidthHistogram(const TEqWidthHistogram& histogram, ui32 numStripes = 1);
+
+    // Adds the given `val` to a histogram, thread safe.
+    template <typename T>
+    void AddElement(T val) {
+        GetCounter(GetStripe(), Layout_.FindContainingBucketIndex<T>(val)).fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Adds all the given `values` to a histogram, thread safe.
+    // Values are counted into thread local counters first, so the shared counters are updated once
+    // per touched bucket, and nothing is allocated or copied per call.
+    template <typename T>
+    void AddElements(TArrayRef<const T> values) {
+        auto& local = GetLocalCounts(GetNumBuckets());
+        for (const auto& val : values) {
+            const auto index = Layout_.FindContainingBucketIndex<T>(val);
+            if (!local.Counts[index]++) {
+                local.Touched.push_back(index);
+            }
+        }
+        FlushLocalCounts(local);
+    }
+
+    // Returns a histogram with the current counts, thread safe.
+    // Every bucket count is observed at some moment during the call, values added concurrently
+    // with the snapshot may be missing in it.
+    TEqWidthHistogram Snapshot() const;
+
+    ui32 GetNumBuckets() const {
+        return Layout_.GetNumBuckets();
+    }
+    EHistogramValueType GetType() const {
+        return Layout_.GetType();
+    }
+
+private:
+    // Counts of the current thread, zero between calls.
+    struct TLocalCounts {
+        TVector<ui64> Counts;
+        // Buckets with non zero counts.
+        TVector<ui32> Touched;
+    };
+
+    static constexpr ui32 CountersPerCacheLine = 64 / sizeof(std::atomic<ui64>);
+
+    // Counters of a cache line, stripes start at a cache line boundary and never share one.
+    struct alignas(64) TCacheLine {
+        std::atomic<ui64> Counters[CountersPerCacheLine];
+    };
+    static_assert(sizeof(TCacheLine) == 64 && alignof(TCacheLine) == 64);
+
+    template <typename TLine>
+    static auto& GetCounter(TLine* stripe, ui32 index) {
+        return stripe[index / CountersPerCacheLine].Counters[index % CountersPerCacheLine];
+    }
+    TCacheLine* GetStripe();
+    // Returns counts of the current thread with at least `numBuckets` buckets.
+    static TLocalCounts& GetLocalCounts(ui32 numBuckets);
+    // Adds the given `local` counts to the shared ones and zeroes them.
+    void FlushLocalCounts(TLocalCounts& local);
+
+    // Holds the layout, counts are always zero.
+    TEqWidthHistogram Layout_;
+    ui32 NumStripes_;
+    // Number of cache lines per stripe.
+    ui32 StripeSize_;
+    std::unique_ptr<TCacheLine[]> Counts_;
+};
+
+} // namespace NKikimr
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "eq_width_histogram.h"
+
+#include <util/random/fast.h>
+
+namespace NKikimr {
+
+// Builds an `Equal-width` histogram from a Bernoulli sample of rows, so the cost is proportional to
+// the sample size rather than the number of rows.
+// Every row is sampled independently with the probability `sampleRate`, the gaps between sampled
+// rows are drawn from the geometric distribution, so the random generator is called once per
+// sampled row and skipped rows are not touched at all.
+// Counts of the result are scaled by the number of rows over the number of sampled rows.
+// The standard error of estimates is reported by the estimator with `TSettings::SampleRate` set to
+// `GetSampleRate()`.
+template <typename T>
+class TSampledEqWidthHistogramBuilder {
+public:
+    // Buckets are taken from the `layout`, its counts are not used.
+    TSampledEqWidthHistogramBuilder(const TEqWidthHistogram& layout, double sampleRate, ui64 seed = 0)
+        : Histogram_(layout)
+        , SampleRate_(sampleRate)
+        , Rng_(seed)
+    {
+        Y_ABORT_UNLESS(sampleRate > 0 && sampleRate <= 1);
+        Histogram_.ResetCounts();
+        // A sample does not tell the number of distinct values of all rows.
+        Histogram_.DisableNdv();
+        if (SampleRate_ < 1) {
+            InvLogSkipRate_ = 1.0 / std::log1p(-SampleRate_);
+        }
+        Skip_ = NextSkip();
+    }
+
+    // Adds the next row.
+    void AddElement(T val) {
+        ++NumRows_;
+        if (Skip_) {
+            --Skip_;
+            return;
+        }
+        Sample(val);
+    }
+
+    // Adds the next rows, only the sampled ones are read.
+    void AddElements(TArrayRef<const T> values) {
+        NumRows_ += values.size();
+        for (size_t i = 0;; ++i) {
+            if (Skip_ >= values.size() - i) {
+                Skip_ -= values.size() - i;
+                return;
+            }
+            i += Skip_;
+            Sample(values[i]);
+        }
+    }
+
+    // Returns the histogram with scaled counts. The total count is the number of rows if at least
+    // one row was sampled. Distinct values are not counted.
+    TEqWidthHistogram Finish() const {
+        TEqWidthHistogram result(Histogram_);
+        result.ResetCounts();
+        if (!NumSampled_) {
+            return result;
+        }
+        const double scale = static_cast<double>(NumRows_) / NumSampled_;
+        // Round cumulative counts, so the rounding errors do not add up.
+        ui64 sampled = 0;
+        ui64 prev = 0;
+        for (ui32 i = 0; i < Histogram_.GetNumBuckets(); ++i) {
+            sampled += Histogram_.GetNumElementsInBucket(i);
+            const ui64 next = std::min(NumRows_, static_cast<ui64>(sampled * scale + 0.5));
+            result.AddToBucket(i, next - prev);
+            prev = next;
+        }
+        return result;
+    }
+
+    // Returns the number of added rows.
+    ui64 GetNumRows() const {
+        return NumRows_;
+    }
+    // Returns the number of sampled rows.
+    ui64 GetNumSampled() const {
+        return NumSampled_;
+    }
+    // Returns the sample rate: the configured one before any row was sampled, the effective one
+    // after.
+    double GetSampleRate() const {
+        return NumSampled_ ? static_cast<double>(NumSampled_) / NumRows_ : SampleRate_;
+    }
+
+private:
+    void Sample(T val) {
+        Histogram_.AddElement<T>(val);
+        ++NumSampled_;
+        Skip_ = NextSkip();
+    }
+
+    // Returns the number of rows to skip before the next sampled one.
+    ui64 NextSkip() {
+        if (SampleRate_ >= 1) {
+            return 0;
+        }
+        const double skip = std::floor(std::log(Rng_.GenRandReal3()) * InvLogSkipRate_);
+        return skip < static_cast<double>(std::numeric_limits<ui64>::max() / 2) ? static_cast<ui64>(skip) : std::numeric_limits<ui64>::max() / 2;
+    }
+
+    TEqWidthHistogram Histogram_;
+    double SampleRate_;
+    // 1 / log(1 - sampleRate).
+    double InvLogSkipRate_{0};
+    TFastRng64 Rng_;
+    ui64 Skip_{0};
+    ui64 NumRows_{0};
+    ui64 NumSampled_{0};
+};
+
+} // namespace NKikimr
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "eq_width_histogram.h"
+
+namespace NKikimr {
+
+// This class represents an `Equal-width` histogram over values of the type `T`.
+// It has the same semantics as `TEqWidthHistogram` but stores the starts as native values and all
+// methods are inlinable, so hot loops do not pay for the type erasure. Use
+// `VisitHistogramValueType()` to dispatch from the runtime value type once.
+template <typename T>
+class TEqWidthHistogramT {
+public:
+    using TValue = T;
+
+    explicit TEqWidthHistogramT(ui32 numBuckets = 1, EHistogramValueType type = GetHistogramValueType<T>())
+        : ValueType_(type)
+        , Starts_(numBuckets)
+        , Counts_(numBuckets)
+    {
+        Y_ASSERT(numBuckets >= 1);
+        Y_ASSERT(sizeof(T) == GetHistogramValueTypeSize(type));
+    }
+
+    // From the type erased histogram, the value type of `histogram` has to match `T`.
+    explicit TEqWidthHistogramT(const TEqWidthHistogram& histogram)
+        : ValueType_(histogram.GetType())
+        , Starts_(histogram.GetStarts<T>().begin(), histogram.GetStarts<T>().end())
+        , Counts_(histogram.GetCounts().begin(), histogram.GetCounts().end())
+    {
+        UpdateEqWidthLayout();
+    }
+
+    // Converts to the type erased histogram.
+    TEqWidthHistogram ToHistogram() const {
+        return TEqWidthHistogram(ValueType_, TArrayRef<const T>(Starts_.data(), Starts_.size()), GetCounts());
+    }
+
+    // Adds the given `val` to a histogram.
+    void AddElement(T val) {
+        Counts_[FindContainingBucketIndex(val)]++;
+    }
+
+    // Adds all the given `values` to a histogram.
+    void AddElements(TArrayRef<const T> values) {
+        if (EqWidthLayout_) {
+            NPrivate::CountEqWidth<T>(Layout_, GetStartLoader(), values, Counts_.data());
+            return;
+        }
+        for (const auto& val : values) {
+            AddElement(val);
+        }
+    }
+
+    // Returns an index of the first bucket with start >= `val`, or the last bucket,
+    // the same as `TEqWidthHistogram::FindBucketIndex()`.
+    ui32 FindBucketIndex(T val) const {
+        if (EqWidthLayout_) {
+            return NPrivate::LowerBoundBucketIndex<T>(Layout_, GetStartLoader(), val);
+        }
+        return std::min<ui32>(std::lower_bound(Starts_.begin(), Starts_.end(), val, CmpLess<T>) - Starts_.begin(), GetNumBuckets() - 1);
+    }
+
+    // Returns an index of the bucket which contains the given `val`.
+    ui32 FindContainingBucketIndex(T val) const {
+        if (EqWidthLayout_) {
+            return NPrivate::ContainingBucketIndex<T>(Layout_, GetStartLoader(), val);
+        }
+        const ui32 index = FindBucketIndex(val);
+        if (!index || !CmpLess<T>(val, Starts_[index])) {
+            return index;
+        }
+        return index - 1;
+    }
+
+    // Initializes buckets with a given range, the same as `TEqWidthHistogram::InitializeBuckets()`.
+    void InitializeBuckets(T start, T end) {
+        Y_ASSERT(CmpLess<T>(start, end));
+        const ui32 numBuckets = NPrivate::FillEqWidthStarts<T>(start, end, {Starts_.data(), Starts_.size()});
+        Starts_.resize(numBuckets);
+        Counts_.resize(numBuckets);
+        UpdateEqWidthLayout();
+    }
+
+    // Adds counts of the `other` histogram, returns false if the types are different, the same as
+    // `TEqWidthHistogram::Aggregate()`. Different buckets are projected onto a common layout through
+    // the type erased histograms, which is not the hot path.
+    bool Aggregate(const TEqWidthHistogramT& other) {
+        if (ValueType_ != other.ValueType_) {
+            return false;
+        }
+        if (Starts_ != other.Starts_) {
+            auto histogram = ToHistogram();
+            const bool aggregated = histogram.template Aggregate<T>(other.ToHistogram());
+            Y_ABORT_UNLESS(aggregated);
+            *this = TEqWidthHistogramT(histogram);
+            return true;
+        }
+        for (ui32 i = 0; i < GetNumBuckets(); ++i) {
+            Counts_[i] += other.Counts_[i];
+        }
+        return true;
+    }
+
+    ui32 GetNumBuckets() const {
+        return Counts_.size();
+    }
+    EHistogramValueType GetType() const {
+        return ValueType_;
+    }
+    ui64 GetNumElementsInBucket(ui32 index) const {
+        return Counts_[index];
+    }
+    T GetBucketStart(ui32 index) const {
+        return Starts_[index];
+    }
+    TArrayRef<const ui64> GetCounts() const {
+        return {Counts_.data(), Counts_.size()};
+    }
+    TArrayRef<const T> GetStarts() const {
+        return {Starts_.data(), Starts_.size()};
+    }
+    bool IsEqWidthLayout() const {
+        return EqWidthLayout_;
+    }
+
+private:
+    auto GetStartLoader() const {
+        return [starts = Starts_.data()](ui32 index) {
+            return starts[index];
+        };
+    }
+
+    void UpdateEqWidthLayout() {
+        EqWidthLayout_ = NPrivate::DetectEqWidthLayout<T>(GetNumBuckets(), GetStartLoader(), Layout_);
+    }
+
+    EHistogramValueType ValueType_;
+    TVector<T> Starts_;
+    TVector<ui64> Counts_;
+    bool EqWidthLayout_{false};
+    NPrivate::TEqWidthLayout<T> Layout_;
+};
+
+} // namespace NKikimr
@@ -0,0 +1,80 @@
+#include "eq_width_histogram_view.h"
+
+namespace NKikimr {
+
+TEqWidthHistogramView::TEqWidthHistogramView(const char* str, ui64 size, std::pmr::memory_resource* resource)
+    : CountSums_(resource)
+    , DecodedStarts_(resource)
+{
+    Y_ASSERT(str);
+    Y_ENSURE(size >= sizeof(ui32) + sizeof(EHistogramValueType), "Truncated histogram");
+    const ui8* data = reinterpret_cast<const ui8*>(str);
+    NumBuckets_ = LoadFrom<ui32>(data);
+    if (NumBuckets_ != HistogramVersionedFormatMarker) {
+        Y_ENSURE(sizeof(ui32) + sizeof(EHistogramValueType) + sizeof(TEqWidthHistogram::TBucket) * static_cast<ui64>(NumBuckets_) == size,
+                 "Histogram size does not match the number of buckets");
+        ValueType_ = LoadFrom<EHistogramValueType>(data + sizeof(ui32));
+        Y_ENSURE(IsValidHistogramValueType(ValueType_), "Unknown histogram value type " << static_cast<ui32>(ValueType_));
+        const ui8* buckets = data + sizeof(ui32) + sizeof(EHistogramValueType);
+        Starts_ = buckets + offsetof(TEqWidthHistogram::TBucket, Start);
+        StartsStride_ = sizeof(TEqWidthHistogram::TBucket);
+        Decode(buckets + offsetof(TEqWidthHistogram::TBucket, Count), nullptr, str + size, nullptr, nullptr);
+        return;
+    }
+
+    // [4 byte: zero marker][1 byte: version][1 byte: value type][1 byte: flags][4 byte: number of buckets].
+    constexpr ui64 headerSize = sizeof(ui32) + 3 * sizeof(ui8) + sizeof(ui32);
+    Y_ENSURE(size >= headerSize, "Truncated histogram");
+    const ui8 version = LoadFrom<ui8>(data + sizeof(ui32));
+    Y_ENSURE(version == static_cast<ui8>(EHistogramFormat::V2), "Unknown histogram format " << static_cast<ui32>(version));
+    ValueType_ = LoadFrom<EHistogramValueType>(data + sizeof(ui32) + sizeof(ui8));
+    Y_ENSURE(IsValidHistogramValueType(ValueType_), "Unknown histogram value type " << static_cast<ui32>(ValueType_));
+    const ui8 flags = LoadFrom<ui8>(data + sizeof(ui32) + 2 * sizeof(ui8));
+    NumBuckets_ = LoadFrom<ui32>(data + sizeof(ui32) + 3 * sizeof(ui8));
+    Y_ENSURE(NumBuckets_ >= 1, "Malformed number of histogram buckets");
+    StartsStride_ = GetHistogramValueTypeSize(ValueType_);
+    const ui8* starts = data + headerSize;
+    const ui8* compactStart = nullptr;
+    ui64 startsSize = 0;
+    if (flags & NPrivate::EqWidthLayoutFlag) {
+        Y_ENSURE(ValueType_ != EHistogramValueType::NotSupported, "Equal-width layout of unsupported values");
+        compactStart = starts;
+        startsSize = StartsStride_ + EqWidthHistogramBucketStorageSize;
+    } else {
+        Starts_ = starts;
+        startsSize = static_cast<ui64>(StartsStride_) * NumBuckets_;
+    }
+    // Every bucket takes at least a byte of its count.
+    Y_ENSURE(size >= headerSize + startsSize + NumBuckets_, "Truncated histogram");
+    Decode(nullptr, str + headerSize + startsSize, str + size, compactStart, compactStart ? compactStart + StartsStride_ : nullptr);
+}
+
+void TEqWidthHistogramView::Decode(const ui8* counts, const char* varintCounts, const char* end, const ui8* compactStart, const ui8* compactWidth) {
+    CountSums_.resize(static_cast<ui64>(NumBuckets_) + 1);
+    CountSums_[0] = 0;
+    const char* in = varintCounts;
+    for (ui32 i = 0; i < NumBuckets_; ++i) {
+        ui64 count = 0;
+        if (counts) {
+            count = LoadFrom<ui64>(counts + static_cast<ui64>(i) * sizeof(TEqWidthHistogram::TBucket));
+        } else {
+            in = NPrivate::ReadVarint(in, end, count);
+        }
+        CountSums_[i + 1] = CountSums_[i] + count;
+    }
+    if (!compactStart) {
+        return;
+    }
+    DecodedStarts_.resize(static_cast<ui64>(StartsStride_) * NumBuckets_);
+    VisitHistogramValueType(ValueType_, [&](auto tag) {
+        using T = typename decltype(tag)::type;
+        const auto width = LoadFrom<NPrivate::TBucketWidth<T>>(compactWidth);
+        T start = LoadFrom<T>(compactStart);
+        for (ui32 i = 0; i < NumBuckets_; ++i) {
+            std::memcpy(DecodedStarts_.data() + static_cast<ui64>(i) * sizeof(T), &start, sizeof(T));
+            start = NPrivate::NextStart<T>(start, width);
+        }
+    });
+}
+
+} // namespace NKikimr
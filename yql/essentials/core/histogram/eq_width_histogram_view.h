@@ -0,0 +1,155 @@
+#pragma once
+
+#include "eq_width_histogram.h"
+
+namespace NKikimr {
+
+// This class represents a read-only view over a serialized `Equal-width` histogram of the
+// `EHistogramFormat::V1` or `V2` format. Starts are read directly from the serialized buffer by
+// `LoadFrom()`, the buffer does not have to be aligned. The view allocates on construction:
+// counts are summed into `N + 1` prefix sums, so estimates take O(log N) and do not allocate.
+// `V2` varint counts and starts of its compact layout, which are accumulated from the first one,
+// are decoded at the same time. The storage is taken from `resource`. Distinct count sketches
+// are not read. The view does not own the buffer, it has to outlive the view, which can be copied
+// and moved. Malformed data throws `yexception` on construction.
+class TEqWidthHistogramView {
+public:
+    TEqWidthHistogramView(const char* str, ui64 size, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    ui32 GetNumBuckets() const {
+        return NumBuckets_;
+    }
+    EHistogramValueType GetType() const {
+        return ValueType_;
+    }
+    ui64 GetNumElementsInBucket(ui32 index) const {
+        Y_ASSERT(index < NumBuckets_);
+        return SumCounts(index, index + 1);
+    }
+    template <typename T>
+    T GetBucketStart(ui32 index) const {
+        Y_ASSERT(index < NumBuckets_);
+        const ui8* starts = Starts_ ? Starts_ : DecodedStarts_.data();
+        return LoadFrom<T>(starts + static_cast<ui64>(index) * StartsStride_);
+    }
+
+    // Returns an index of the first bucket with start >= `val`, or the last bucket,
+    // the same as `TEqWidthHistogram::FindBucketIndex()`.
+    // The index is guessed from the width of the first bucket and checked against the neighbour
+    // starts, the binary search is used if the guess is wrong.
+    template <typename T>
+    ui32 FindBucketIndex(T val) const {
+        const ui32 last = NumBuckets_ - 1;
+        if (!last || !CmpLess<T>(GetBucketStart<T>(0), val)) {
+            return 0;
+        }
+        const T start = GetBucketStart<T>(0);
+        const T next = GetBucketStart<T>(1);
+        if (CmpLess<T>(start, next)) {
+            const double q = static_cast<double>(NPrivate::ValueDiff<T>(val, start)) / static_cast<double>(NPrivate::ValueDiff<T>(next, start));
+            const ui32 guess = q < static_cast<double>(last) ? static_cast<ui32>(std::ceil(q)) : last;
+            if (IsLowerBound<T>(guess, val)) {
+                return guess;
+            }
+        }
+        ui32 left = 0;
+        ui32 right = last;
+        while (left < right) {
+            const ui32 it = left + (right - left) / 2;
+            if (CmpLess<T>(GetBucketStart<T>(it), val)) {
+                left = it + 1;
+            } else {
+                right = it;
+            }
+        }
+        return left;
+    }
+
+    // Returns an index of the last bucket with start <= `val`, or the first bucket,
+    // the same as `TEqWidthHistogram::FindContainingBucketIndex()`.
+    template <typename T>
+    ui32 FindContainingBucketIndex(T val) const {
+        const auto index = FindBucketIndex<T>(val);
+        const T start = GetBucketStart<T>(index);
+        if (!index || CmpEqual<T>(start, val) || CmpLess<T>(start, val)) {
+            return index;
+        }
+        return index - 1;
+    }
+
+    // Methods to estimate values, the same as `TEqWidthHistogramEstimator` ones.
+    template <typename T>
+    ui64 EstimateLessOrEqual(T val) const {
+        return SumCounts(0, FindBucketIndex<T>(val) + 1);
+    }
+
+    template <typename T>
+    ui64 EstimateGreaterOrEqual(T val) const {
+        return SumCounts(FindBucketIndex<T>(val), NumBuckets_);
+    }
+
+    template <typename T>
+    ui64 EstimateLess(T val) const {
+        const auto index = FindBucketIndex<T>(val);
+        return SumCounts(0, index ? index : 1);
+    }
+
+    template <typename T>
+    ui64 EstimateGreater(T val) const {
+        const auto index = FindBucketIndex<T>(val);
+        return SumCounts(index ? index - 1 : 0, NumBuckets_);
+    }
+
+    template <typename T>
+    ui64 EstimateEqual(T val) const {
+        const auto index = FindContainingBucketIndex<T>(val);
+        // Assuming uniform distribution.
+        return std::max<ui64>(1, GetNumElementsInBucket(index) / GetBucketWidth<T>());
+    }
+
+    // Returns the total number elements in histogram.
+    ui64 GetNumElements() const {
+        return SumCounts(0, NumBuckets_);
+    }
+
+private:
+    template <typename T>
+    bool IsLowerBound(ui32 index, T val) const {
+        return (!index || CmpLess<T>(GetBucketStart<T>(index - 1), val)) &&
+               (index == NumBuckets_ - 1 || !CmpLess<T>(GetBucketStart<T>(index), val));
+    }
+    template <typename T>
+    ui64 GetBucketWidth() const {
+        if (NumBuckets_ == 1) {
+            return std::max<ui64>(static_cast<ui64>(GetBucketStart<T>(0)), 1);
+        }
+        return std::max<ui64>(NPrivate::ValueDiff<T>(GetBucketStart<T>(1), GetBucketStart<T>(0)), 1);
+    }
+    // Returns the sum of counts of buckets in [from, to).
+    ui64 SumCounts(ui32 from, ui32 to) const {
+        return CountSums_[to] - CountSums_[from];
+    }
+    void Decode(const ui8* counts, const char* varintCounts, const char* end, const ui8* compactStart, const ui8* compactWidth);
+
+    ui32 NumBuckets_;
+    EHistogramValueType ValueType_;
+    // Starts in the buffer, null for the compact layout, which starts are decoded.
+    // Starts of the `V1` format are interleaved with counts, a stride is the size of a bucket.
+    const ui8* Starts_{nullptr};
+    ui32 StartsStride_{0};
+    // Prefix sums of counts, `NumBuckets_ + 1` values.
+    std::pmr::vector<ui64> CountSums_;
+    // Starts of the compact layout of the `V2` format.
+    std::pmr::vector<ui8> DecodedStarts_;
+};
+
+template <>
+inline ui64 TEqWidthHistogramView::GetBucketWidth<double>() const {
+    return 1;
+}
+template <>
+inline ui64 TEqWidthHistogramView::GetBucketWidth<float>() const {
+    return 1;
+}
+
+} // namespace NKikimr
@@ -0,0 +1,37 @@
+#include "eq_width_histogram_windowed.h"
+
+namespace NKikimr {
+
+TWindowedEqWidthHistogram::TWindowedEqWidthHistogram(const TEqWidthHistogram& layout, ui32 numEpochs)
+    : Total_(layout)
+    , NumEpochs_(std::max(numEpochs, 1U))
+    , EpochCounts_(static_cast<ui64>(NumEpochs_) * layout.GetNumBuckets())
+{
+    Total_.ResetCounts();
+    Total_.DisableNdv();
+}
+
+void TWindowedEqWidthHistogram::Advance() {
+    ++Epoch_;
+    auto* counts = CurrentCounts();
+    Total_.SubtractCounts({counts, Total_.GetNumBuckets()});
+    std::fill(counts, counts + Total_.GetNumBuckets(), 0);
+}
+
+void TWindowedEqWidthHistogram::AdvanceTo(ui64 epoch) {
+    if (epoch <= Epoch_) {
+        return;
+    }
+    if (epoch - Epoch_ >= NumEpochs_) {
+        // The whole window is left.
+        Total_.ResetCounts();
+        std::fill(EpochCounts_.begin(), EpochCounts_.end(), 0);
+        Epoch_ = epoch;
+        return;
+    }
+    while (Epoch_ < epoch) {
+        Advance();
+    }
+}
+
+} // namespace NKikimr
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "eq_width_histogram.h"
+
+namespace NKikimr {
+
+// This class represents an `Equal-width` histogram of the values added during the last `numEpochs`
+// epochs, e.g. for statistics of a topic where the distribution shifts over time.
+// Counts of every epoch are kept in a ring, and the histogram of the window is kept as a running
+// total: adding a value and reading the histogram are O(1), advancing an epoch is O(numBuckets).
+// The layout is fixed, distinct counts are not windowed and are not kept.
+class TWindowedEqWidthHistogram {
+public:
+    // Buckets are taken from the `layout`, its counts are not used.
+    TWindowedEqWidthHistogram(const TEqWidthHistogram& layout, ui32 numEpochs);
+
+    template <typename T>
+    void AddElement(T val) {
+        CurrentCounts()[Total_.AddElement<T>(val)]++;
+    }
+
+    template <typename T>
+    void AddElements(TArrayRef<const T> values) {
+        auto* counts = CurrentCounts();
+        for (const auto& val : values) {
+            counts[Total_.AddElement<T>(val)]++;
+        }
+    }
+
+    // Starts a new epoch, the values of the oldest one leave the window.
+    void Advance();
+    // Advances to the given `epoch`, e.g. the current time over the epoch duration. Epochs before
+    // the current one are ignored.
+    void AdvanceTo(ui64 epoch);
+
+    // Returns the histogram of the values of the window. Estimators of the histogram have to be
+    // refreshed after values are added or an epoch is advanced.
+    const TEqWidthHistogram& GetHistogram() const {
+        return Total_;
+    }
+    ui64 GetEpoch() const {
+        return Epoch_;
+    }
+    ui32 GetNumEpochs() const {
+        return NumEpochs_;
+    }
+
+private:
+    ui64* CurrentCounts() {
+        return EpochCounts_.data() + static_cast<ui64>(Epoch_ % NumEpochs_) * Total_.GetNumBuckets();
+    }
+
+    TEqWidthHistogram Total_;
+    ui32 NumEpochs_;
+    ui64 Epoch_{0};
+    // Counts of buckets of every epoch of the window, the current epoch is `Epoch_ % NumEpochs_`.
+    TVector<ui64> EpochCounts_;
+};
+
+} // namespace NKikimr
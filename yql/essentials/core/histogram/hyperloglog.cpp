@@ -0,0 +1,73 @@
+#include "hyperloglog.h"
+
+#include <util/generic/yexception.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace NKikimr {
+
+THyperLogLogSketch::THyperLogLogSketch(ui32 precision)
+    : Precision_(precision)
+    , Registers_(1ULL << precision)
+{
+    Y_ABORT_UNLESS(precision >= MinPrecision && precision <= MaxPrecision);
+}
+
+bool THyperLogLogSketch::Merge(const THyperLogLogSketch& other) {
+    if (Precision_ != other.Precision_) {
+        return false;
+    }
+    for (size_t i = 0; i < Registers_.size(); ++i) {
+        Registers_[i] = std::max(Registers_[i], other.Registers_[i]);
+    }
+    return true;
+}
+
+ui64 THyperLogLogSketch::Estimate() const {
+    const double m = Registers_.size();
+    double sum = 0;
+    ui32 zeros = 0;
+    for (const auto reg : Registers_) {
+        sum += std::ldexp(1.0, -static_cast<int>(reg));
+        zeros += !reg;
+    }
+    double alpha;
+    switch (Precision_) {
+        case 4:
+            alpha = 0.673;
+            break;
+        case 5:
+            alpha = 0.697;
+            break;
+        case 6:
+            alpha = 0.709;
+            break;
+        default:
+            alpha = 0.7213 / (1 + 1.079 / m);
+    }
+    double estimate = alpha * m * m / sum;
+    // The linear counting is more precise for the small cardinalities. The large range correction
+    // is not needed with 64-bit hashes.
+    if (estimate <= 2.5 * m && zeros) {
+        estimate = m * std::log(m / zeros);
+    }
+    return static_cast<ui64>(estimate + 0.5);
+}
+
+void THyperLogLogSketch::Reset() {
+    std::fill(Registers_.begin(), Registers_.end(), 0);
+}
+
+const char* THyperLogLogSketch::Deserialize(const char* in, const char* end) {
+    Y_ENSURE(in < end, "Truncated HyperLogLog sketch");
+    const ui8 precision = static_cast<ui8>(*in++);
+    Y_ENSURE(precision >= MinPrecision && precision <= MaxPrecision, "Malformed HyperLogLog precision " << static_cast<ui32>(precision));
+    const ui64 size = 1ULL << precision;
+    Y_ENSURE(static_cast<ui64>(end - in) >= size, "Truncated HyperLogLog sketch");
+    Precision_ = precision;
+    Registers_.assign(in, in + size);
+    return in + size;
+}
+
+} // namespace NKikimr
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <util/generic/vector.h>
+#include <util/system/types.h>
+#include <util/system/yassert.h>
+
+#include <bit>
+#include <cstring>
+#include <type_traits>
+
+namespace NKikimr {
+
+// Returns a 64-bit hash of the given histogram value for the distinct counting.
+template <typename T>
+inline ui64 HashHistogramValue(T val) {
+    if constexpr (std::is_floating_point_v<T>) {
+        // -0.0 and 0.0 are the same value.
+        if (val == 0) {
+            val = 0;
+        }
+    }
+    ui64 bits = 0;
+    std::memcpy(&bits, &val, sizeof(T));
+    // The splitmix64 finalizer.
+    bits ^= bits >> 30;
+    bits *= 0xBF58476D1CE4E5B9ULL;
+    bits ^= bits >> 27;
+    bits *= 0x94D049BB133111EBULL;
+    bits ^= bits >> 31;
+    return bits;
+}
+
+// This class represents a HyperLogLog sketch (Flajolet, Fusy, Gandouet, Meunier) of the number of
+// distinct values. It keeps 2^precision one byte registers, the relative standard error of the
+// estimate is about 1.04 / sqrt(2^precision), e.g. 3.25% for the precision 10 in 1 KiB.
+// Sketches with the same precision are merged by the maximum of the registers.
+class THyperLogLogSketch {
+public:
+    static constexpr ui32 MinPrecision = 4;
+    static constexpr ui32 MaxPrecision = 16;
+
+    explicit THyperLogLogSketch(ui32 precision = 10);
+
+    // Adds a value with the given `hash`, hashes have to be uniformly distributed.
+    void AddHash(ui64 hash) {
+        const ui64 index = hash >> (64 - Precision_);
+        const ui64 rest = hash << Precision_;
+        // The position of the first set bit in the rest of the hash.
+        const ui8 rank = rest ? std::countl_zero(rest) + 1 : 64 - Precision_ + 1;
+        if (Registers_[index] < rank) {
+            Registers_[index] = rank;
+        }
+    }
+
+    template <typename T>
+    void AddValue(T val) {
+        AddHash(HashHistogramValue<T>(val));
+    }
+
+    // Merges the `other` sketch into this one, returns false if the precisions are different.
+    bool Merge(const THyperLogLogSketch& other);
+    // Returns the estimated number of distinct values.
+    ui64 Estimate() const;
+    // Removes all values.
+    void Reset();
+
+    ui32 GetPrecision() const {
+        return Precision_;
+    }
+
+    // Binary layout: [1 byte: precision][2^precision bytes: registers].
+    ui64 GetSerializedSize() const {
+        return sizeof(ui8) + Registers_.size();
+    }
+    // `write(data, size)` is called for the consecutive parts.
+    template <typename TWrite>
+    void SerializeTo(TWrite&& write) const {
+        write(&Precision_, sizeof(ui8));
+        write(Registers_.data(), Registers_.size());
+    }
+    // Reads a sketch from [in, end), returns the pointer past it. Throws `yexception` if the data is
+    // malformed.
+    const char* Deserialize(const char* in, const char* end);
+
+private:
+    ui8 Precision_;
+    TVector<ui8> Registers_;
+};
+
+} // namespace NKikimr
@@ -0,0 +1,237 @@
+#pragma once
+
+#include "eq_depth_histogram.h"
+#include "eq_width_histogram.h"
+
+namespace NKikimr {
+
+// This class represents a KLL quantile sketch (Karnin, Lang, Liberty, "Optimal Quantile
+// Approximation in Streams"). It collects values in one pass with bounded memory, O(k log(n / k))
+// values, and estimates ranks with the error of about 1.7 / k of the number of values. Sketches
+// are mergeable, so partial sketches of shards or threads could be combined.
+// At the end a sketch emits an `Equal-width` histogram over the observed [min, max] range or an
+// `Equi-depth` histogram, so no pass is needed to find the range before collecting.
+// NaN values are skipped.
+template <typename T>
+class TKllSketch {
+public:
+    explicit TKllSketch(ui32 k = 200, ui64 seed = 0x9E3779B97F4A7C15ULL)
+        : K_(std::max<ui32>(k, 8))
+        , Random_(seed | 1)
+        , Levels_(1)
+    {
+        UpdateCapacity();
+    }
+
+    void Add(T val) {
+        if constexpr (std::is_floating_point_v<T>) {
+            if (std::isnan(val)) {
+                return;
+            }
+        }
+        if (!NumValues_ || CmpLess<T>(val, Min_)) {
+            Min_ = val;
+        }
+        if (!NumValues_ || CmpLess<T>(Max_, val)) {
+            Max_ = val;
+        }
+        ++NumValues_;
+        Levels_[0].push_back(val);
+        ++Size_;
+        if (Size_ >= Capacity_) {
+            Compress();
+        }
+    }
+
+    void AddElements(TArrayRef<const T> values) {
+        for (const auto& val : values) {
+            Add(val);
+        }
+    }
+
+    // Merges the `other` sketch into this one.
+    void Merge(const TKllSketch& other) {
+        if (!other.NumValues_) {
+            return;
+        }
+        if (!NumValues_ || CmpLess<T>(other.Min_, Min_)) {
+            Min_ = other.Min_;
+        }
+        if (!NumValues_ || CmpLess<T>(Max_, other.Max_)) {
+            Max_ = other.Max_;
+        }
+        NumValues_ += other.NumValues_;
+        if (Levels_.size() < other.Levels_.size()) {
+            Levels_.resize(other.Levels_.size());
+        }
+        for (ui32 level = 0; level < other.Levels_.size(); ++level) {
+            Levels_[level].insert(Levels_[level].end(), other.Levels_[level].begin(), other.Levels_[level].end());
+            Size_ += other.Levels_[level].size();
+        }
+        UpdateCapacity();
+        while (Size_ >= Capacity_) {
+            Compress();
+        }
+    }
+
+    // Returns the number of added values.
+    ui64 GetNumValues() const {
+        return NumValues_;
+    }
+    T GetMin() const {
+        return Min_;
+    }
+    T GetMax() const {
+        return Max_;
+    }
+    // Returns the number of values kept by a sketch.
+    ui64 GetRetainedSize() const {
+        return Size_;
+    }
+
+    // Returns an estimated number of values less or equal to `val`.
+    ui64 GetRank(T val) const {
+        ui64 rank = 0;
+        for (ui32 level = 0; level < Levels_.size(); ++level) {
+            for (const auto& item : Levels_[level]) {
+                if (!CmpLess<T>(val, item)) {
+                    rank += 1ULL << level;
+                }
+            }
+        }
+        return rank;
+    }
+
+    // Returns an estimated `q`-quantile, `q` in [0, 1].
+    T GetQuantile(double q) const {
+        Y_ABORT_UNLESS(NumValues_);
+        TVector<T> values;
+        TVector<ui64> weights;
+        GetSortedView(values, weights);
+        const double target = std::clamp(q, 0.0, 1.0) * NumValues_;
+        ui64 rank = 0;
+        for (size_t i = 0; i < values.size(); ++i) {
+            rank += weights[i];
+            if (rank >= target) {
+                return values[i];
+            }
+        }
+        return Max_;
+    }
+
+    // Builds an `Equal-width` histogram with at most `numBuckets` buckets over [min, max].
+    TEqWidthHistogram ToEqWidthHistogram(ui32 numBuckets, EHistogramValueType type = GetHistogramValueType<T>()) const {
+        const auto starts = NPrivate::MakeEqWidthStarts<T>(Min_, Max_, numBuckets);
+        TVector<ui64> counts(starts.size());
+        TEqWidthHistogram histogram(type, TArrayRef<const T>(starts.data(), starts.size()), TArrayRef<const ui64>(counts.data(), counts.size()));
+        for (ui32 level = 0; level < Levels_.size(); ++level) {
+            for (const auto& item : Levels_[level]) {
+                histogram.AddToBucket(histogram.FindContainingBucketIndex<T>(item), 1ULL << level);
+            }
+        }
+        return histogram;
+    }
+
+    // Builds an `Equi-depth` histogram with at most `numBuckets` buckets. Distinct counts of buckets
+    // are those of the retained values, so they are lower bounds.
+    TEqDepthHistogram ToEqDepthHistogram(ui32 numBuckets, EHistogramValueType type = GetHistogramValueType<T>()) const {
+        TVector<T> values;
+        TVector<ui64> weights;
+        GetSortedView(values, weights);
+        if (!values.empty()) {
+            // Keep the exact maximum.
+            values.back() = Max_;
+        }
+        return TEqDepthHistogram::FromSortedWeighted<T>(TArrayRef<const T>(values.data(), values.size()),
+                                                        TArrayRef<const ui64>(weights.data(), weights.size()),
+                                                        numBuckets, 1.0, type);
+    }
+
+private:
+    // Returns retained values sorted with their weights.
+    void GetSortedView(TVector<T>& values, TVector<ui64>& weights) const {
+        TVector<std::pair<T, ui64>> items;
+        items.reserve(Size_);
+        for (ui32 level = 0; level < Levels_.size(); ++level) {
+            for (const auto& item : Levels_[level]) {
+                items.emplace_back(item, 1ULL << level);
+            }
+        }
+        std::sort(items.begin(), items.end(), [](const auto& left, const auto& right) {
+            return CmpLess<T>(left.first, right.first);
+        });
+        values.resize(items.size());
+        weights.resize(items.size());
+        for (size_t i = 0; i < items.size(); ++i) {
+            values[i] = items[i].first;
+            weights[i] = items[i].second;
+        }
+    }
+
+    // Returns the capacity of the `level`, capacities decrease geometrically with the depth
+    // below the top level.
+    ui32 GetLevelCapacity(ui32 level) const {
+        const ui32 depth = Levels_.size() - level - 1;
+        return std::max<ui32>(2, static_cast<ui32>(std::ceil(K_ * std::pow(2.0 / 3.0, depth))));
+    }
+
+    void UpdateCapacity() {
+        Capacity_ = 0;
+        for (ui32 level = 0; level < Levels_.size(); ++level) {
+            Capacity_ += GetLevelCapacity(level);
+        }
+    }
+
+    // Compacts the lowest level over its capacity: sorts it and promotes every other value,
+    // starting from a random one, to the next level with the doubled weight.
+    void Compress() {
+        for (ui32 level = 0; level < Levels_.size(); ++level) {
+            if (Levels_[level].size() < GetLevelCapacity(level)) {
+                continue;
+            }
+            if (level + 1 == Levels_.size()) {
+                Levels_.emplace_back();
+            }
+            auto& items = Levels_[level];
+            std::sort(items.begin(), items.end(), CmpLess<T>);
+            // An odd value stays at the level.
+            const bool keepLast = items.size() % 2;
+            T last{};
+            if (keepLast) {
+                last = items.back();
+                items.pop_back();
+            }
+            auto& next = Levels_[level + 1];
+            for (size_t i = NextRandomBit(); i < items.size(); i += 2) {
+                next.push_back(items[i]);
+            }
+            Size_ -= items.size() / 2;
+            items.clear();
+            if (keepLast) {
+                items.push_back(last);
+            }
+            UpdateCapacity();
+            return;
+        }
+        UpdateCapacity();
+    }
+
+    ui32 NextRandomBit() {
+        // xorshift64
+        Random_ ^= Random_ << 13;
+        Random_ ^= Random_ >> 7;
+        Random_ ^= Random_ << 17;
+        return Random_ & 1;
+    }
+
+    ui32 K_;
+    ui64 Random_;
+    TVector<TVector<T>> Levels_;
+    ui64 Size_{0};
+    ui64 Capacity_{0};
+    ui64 NumValues_{0};
+    T Min_{};
+    T Max_{};
+};
+
+} // namespace NKikimr
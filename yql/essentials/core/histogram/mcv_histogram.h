@@ -0,0 +1,255 @@
+#pragma once
+
+#include "eq_width_histogram.h"
+
+#include <util/generic/hash.h>
+
+namespace NKikimr {
+
+// This class represents the Space-Saving summary (Metwally, Agrawal, El Abbadi, "Efficient
+// Computation of Frequent and Top-k Elements in Data Streams") of the most frequent values.
+// It keeps `capacity` counters, a new value replaces the value with the minimal counter and
+// inherits its count as the error. Every value occurring more often than the number of values over
+// `capacity` times is tracked. Counters are kept in a min-heap, so an update is O(log capacity).
+// NaN values are skipped.
+template <typename T>
+class TSpaceSaving {
+public:
+    struct TItem {
+        T Value{};
+        // The estimated number of occurrences, never less than the exact one.
+        ui64 Count{0};
+        // The maximal overestimation of `Count`.
+        ui64 Error{0};
+    };
+
+    explicit TSpaceSaving(ui32 capacity)
+        : Capacity_(std::max<ui32>(capacity, 1))
+    {
+        Items_.reserve(Capacity_);
+        Heap_.reserve(Capacity_);
+        HeapPos_.reserve(Capacity_);
+    }
+
+    void Add(T val, ui64 count = 1) {
+        if constexpr (std::is_floating_point_v<T>) {
+            if (std::isnan(val)) {
+                return;
+            }
+        }
+        NumValues_ += count;
+        if (auto it = Index_.find(val); it != Index_.end()) {
+            Items_[it->second].Count += count;
+            SiftDown(HeapPos_[it->second]);
+            return;
+        }
+        if (Items_.size() < Capacity_) {
+            const ui32 index = Items_.size();
+            Items_.push_back({val, count, 0});
+            Index_.emplace(val, index);
+            Heap_.push_back(index);
+            HeapPos_.push_back(index);
+            SiftUp(index);
+            return;
+        }
+        const ui32 index = Heap_.front();
+        auto& item = Items_[index];
+        Index_.erase(item.Value);
+        item.Error = item.Count;
+        item.Count += count;
+        item.Value = val;
+        Index_.emplace(val, index);
+        SiftDown(0);
+    }
+
+    // Returns tracked values sorted by value.
+    TVector<TItem> GetItems() const {
+        TVector<TItem> items(Items_.begin(), Items_.end());
+        std::sort(items.begin(), items.end(), [](const TItem& left, const TItem& right) {
+            return CmpLess<T>(left.Value, right.Value);
+        });
+        return items;
+    }
+
+    // Returns the number of added values.
+    ui64 GetNumValues() const {
+        return NumValues_;
+    }
+    ui32 GetCapacity() const {
+        return Capacity_;
+    }
+
+private:
+    bool HeapLess(ui32 left, ui32 right) const {
+        return Items_[Heap_[left]].Count < Items_[Heap_[right]].Count;
+    }
+    void HeapSwap(ui32 left, ui32 right) {
+        std::swap(Heap_[left], Heap_[right]);
+        HeapPos_[Heap_[left]] = left;
+        HeapPos_[Heap_[right]] = right;
+    }
+    void SiftUp(ui32 pos) {
+        while (pos && HeapLess(pos, (pos - 1) / 2)) {
+            HeapSwap(pos, (pos - 1) / 2);
+            pos = (pos - 1) / 2;
+        }
+    }
+    void SiftDown(ui32 pos) {
+        while (true) {
+            ui32 min = pos;
+            for (ui32 child = 2 * pos + 1; child <= 2 * pos + 2 && child < Heap_.size(); ++child) {
+                if (HeapLess(child, min)) {
+                    min = child;
+                }
+            }
+            if (min == pos) {
+                return;
+            }
+            HeapSwap(pos, min);
+            pos = min;
+        }
+    }
+
+    ui32 Capacity_;
+    TVector<TItem> Items_;
+    // Indices of `Items_` ordered as a min-heap by the count, and positions of items in the heap.
+    TVector<ui32> Heap_;
+    TVector<ui32> HeapPos_;
+    THashMap<T, ui32> Index_;
+    ui64 NumValues_{0};
+};
+
+// The most common values sorted by value with their numbers of occurrences.
+template <typename T>
+struct TMostCommonValues {
+    TVector<T> Values;
+    TVector<ui64> Counts;
+};
+
+// Builds the most common values and an `Equal-width` histogram of the remaining values in one pass.
+// Values are counted into the histogram and the Space-Saving summary, `Finish()` keeps the values
+// which occur at least the number of values over `numMcv` times for sure, and subtracts their counts
+// from the histogram.
+template <typename T>
+class TMcvEqWidthHistogramBuilder {
+public:
+    // Buckets are taken from the `layout`, its counts are not used.
+    TMcvEqWidthHistogramBuilder(const TEqWidthHistogram& layout, ui32 numMcv)
+        : Histogram_(layout)
+        , Top_(numMcv)
+    {
+        Histogram_.ResetCounts();
+    }
+
+    void AddElement(T val) {
+        Histogram_.AddElement<T>(val);
+        Top_.Add(val);
+    }
+
+    void AddElements(TArrayRef<const T> values) {
+        Histogram_.AddElements<T>(values);
+        for (const auto& val : values) {
+            Top_.Add(val);
+        }
+    }
+
+    // Returns the most common values and fills the `remainder` histogram of the other values.
+    TMostCommonValues<T> Finish(TEqWidthHistogram& remainder) const {
+        TMostCommonValues<T> mcv;
+        TVector<ui64> counts(Histogram_.GetCounts().begin(), Histogram_.GetCounts().end());
+        const ui64 threshold = std::max<ui64>(2, Top_.GetNumValues() / Top_.GetCapacity());
+        for (const auto& item : Top_.GetItems()) {
+            if (item.Count - item.Error < threshold) {
+                continue;
+            }
+            // The estimated count can not exceed the exact count of the bucket.
+            auto& bucketCount = counts[Histogram_.FindContainingBucketIndex<T>(item.Value)];
+            const ui64 count = std::min(item.Count, bucketCount);
+            bucketCount -= count;
+            mcv.Values.push_back(item.Value);
+            mcv.Counts.push_back(count);
+        }
+        remainder = TEqWidthHistogram(Histogram_.GetType(), Histogram_.GetStarts<T>(), TArrayRef<const ui64>(counts.data(), counts.size()));
+        return mcv;
+    }
+
+private:
+    TEqWidthHistogram Histogram_;
+    TSpaceSaving<T> Top_;
+};
+
+// This class represents a machinery to estimate a value by the most common values and the histogram
+// of the remaining values: the most common values are checked first and counted exactly, the
+// histogram estimates the rest.
+template <typename T>
+class TMcvEqWidthHistogramEstimator {
+public:
+    TMcvEqWidthHistogramEstimator(TMostCommonValues<T> mcv, std::shared_ptr<TEqWidthHistogram> remainder,
+                                  TEqWidthHistogramEstimator::TSettings settings = TEqWidthHistogramEstimator::TSettings())
+        : Mcv_(std::move(mcv))
+        , Estimator_(std::move(remainder), settings)
+        , PrefixSum_(Mcv_.Counts.size() + 1)
+    {
+        Y_ABORT_UNLESS(Mcv_.Values.size() == Mcv_.Counts.size());
+        for (size_t i = 0; i < Mcv_.Counts.size(); ++i) {
+            PrefixSum_[i + 1] = PrefixSum_[i] + Mcv_.Counts[i];
+        }
+    }
+
+    ui64 EstimateEqual(T val) const {
+        const auto it = std::lower_bound(Mcv_.Values.begin(), Mcv_.Values.end(), val, CmpLess<T>);
+        if (it != Mcv_.Values.end() && !CmpLess<T>(val, *it)) {
+            return Mcv_.Counts[it - Mcv_.Values.begin()];
+        }
+        return Estimator_.EstimateEqual<T>(val);
+    }
+
+    ui64 EstimateLessOrEqual(T val) const {
+        return Estimator_.EstimateLessOrEqual<T>(val) + GetMcvLess(val, true);
+    }
+
+    ui64 EstimateLess(T val) const {
+        return Estimator_.EstimateLess<T>(val) + GetMcvLess(val, false);
+    }
+
+    ui64 EstimateGreaterOrEqual(T val) const {
+        return Estimator_.EstimateGreaterOrEqual<T>(val) + PrefixSum_.back() - GetMcvLess(val, false);
+    }
+
+    ui64 EstimateGreater(T val) const {
+        return Estimator_.EstimateGreater<T>(val) + PrefixSum_.back() - GetMcvLess(val, true);
+    }
+
+    // Returns a number of elements in the range [lo, hi].
+    ui64 EstimateRange(T lo, T hi) const {
+        if (CmpLess<T>(hi, lo)) {
+            return 0;
+        }
+        return Estimator_.EstimateRange<T>(lo, hi) + GetMcvLess(hi, true) - GetMcvLess(lo, false);
+    }
+
+    // Returns the total number of elements.
+    ui64 GetNumElements() const {
+        return Estimator_.GetNumElements() + PrefixSum_.back();
+    }
+
+    const TMostCommonValues<T>& GetMostCommonValues() const {
+        return Mcv_;
+    }
+
+private:
+    // Returns the number of the most common values less than `val`, or less or equal if `orEqual`.
+    ui64 GetMcvLess(T val, bool orEqual) const {
+        const auto& values = Mcv_.Values;
+        const auto it = orEqual ? std::upper_bound(values.begin(), values.end(), val, CmpLess<T>)
+                                : std::lower_bound(values.begin(), values.end(), val, CmpLess<T>);
+        return PrefixSum_[it - values.begin()];
+    }
+
+    TMostCommonValues<T> Mcv_;
+    TEqWidthHistogramEstimator Estimator_;
+    // Prefix sums of the counts of the most common values.
+    TVector<ui64> PrefixSum_;
+};
+
+} // namespace NKikimr
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <util/memory/pool.h>
+
+#include <memory_resource>
+
+namespace NKikimr {
+
+// This class adapts `TMemoryPool` to `std::pmr::memory_resource`, so histograms and estimators
+// of many columns could be allocated from one arena and freed at once with the pool.
+// Deallocation is a no-op, memory is returned when the pool is cleared or destroyed. Arrays of
+// histograms allocated from the pool must not be used after that, destructors of histograms and
+// estimators could be skipped if they do not keep NDV sketches, which are allocated from the heap.
+class TMemoryPoolResource final: public std::pmr::memory_resource {
+public:
+    explicit TMemoryPoolResource(TMemoryPool& pool)
+        : Pool_(pool)
+    {
+    }
+
+    TMemoryPool& GetPool() const {
+        return Pool_;
+    }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        return Pool_.Allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        const auto* resource = dynamic_cast<const TMemoryPoolResource*>(&other);
+        return resource && &resource->Pool_ == &Pool_;
+    }
+
+    TMemoryPool& Pool_;
+};
+
+} // namespace NKikimr
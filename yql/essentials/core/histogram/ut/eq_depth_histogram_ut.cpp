@@ -0,0 +1,93 @@
+#include <yql/essentials/core/histogram/eq_depth_histogram.h>
+
+#include <library/cpp/testing/unittest/registar.h>
+
+#include <util/random/fast.h>
+#include <util/stream/str.h>
+
+namespace NKikimr {
+
+namespace {
+
+TVector<i32> MakeSkewedValues(ui32 numValues) {
+    TFastRng64 rng(3);
+    TVector<i32> values;
+    for (ui32 i = 0; i < numValues; ++i) {
+        const double x = rng.GenRandReal3();
+        values.push_back(static_cast<i32>(1000 * x * x * x));
+    }
+    std::sort(values.begin(), values.end());
+    return values;
+}
+
+} // namespace
+
+Y_UNIT_TEST_SUITE(EqDepthHistogram) {
+    Y_UNIT_TEST(BucketsHaveEqualDepth) {
+        const auto values = MakeSkewedValues(10000);
+        const auto histogram = TEqDepthHistogram::FromSorted<i32>(values, 10);
+        UNIT_ASSERT_VALUES_EQUAL(histogram.GetNumBuckets(), 10);
+        UNIT_ASSERT_VALUES_EQUAL(histogram.GetEnd<i32>(), values.back());
+        ui64 total = 0;
+        for (ui32 i = 0; i < histogram.GetNumBuckets(); ++i) {
+            UNIT_ASSERT_DOUBLES_EQUAL(histogram.GetNumElementsInBucket(i), 1000.0, 200.0);
+            total += histogram.GetNumElementsInBucket(i);
+            if (i) {
+                UNIT_ASSERT(CmpLess<i32>(histogram.GetBucketStart<i32>(i - 1), histogram.GetBucketStart<i32>(i)));
+            }
+        }
+        UNIT_ASSERT_VALUES_EQUAL(total, values.size());
+    }
+
+    Y_UNIT_TEST(HeavyValueGetsOwnBucket) {
+        TVector<i32> values(5000, 7);
+        for (i32 val = 0; val < 5000; ++val) {
+            values.push_back(100 + val);
+        }
+        std::sort(values.begin(), values.end());
+        const auto histogram = TEqDepthHistogram::FromSorted<i32>(values, 10);
+        TEqDepthHistogramEstimator estimator(std::make_shared<TEqDepthHistogram>(histogram));
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateEqual<i32>(7), 5000);
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateLess<i32>(7), 0);
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateLessOrEqual<i32>(7), 5000);
+    }
+
+    Y_UNIT_TEST(EstimatesAreClose) {
+        const auto values = MakeSkewedValues(10000);
+        TEqDepthHistogramEstimator estimator(std::make_shared<TEqDepthHistogram>(TEqDepthHistogram::FromSorted<i32>(values, 32)));
+        UNIT_ASSERT_VALUES_EQUAL(estimator.GetNumElements(), values.size());
+        for (i32 val = -10; val <= 1010; val += 17) {
+            const double less = std::lower_bound(values.begin(), values.end(), val) - values.begin();
+            UNIT_ASSERT_DOUBLES_EQUAL(estimator.EstimateLess<i32>(val), less, values.size() / 32.0);
+        }
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateLess<i32>(-10), 0);
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateLessOrEqual<i32>(2000), values.size());
+    }
+
+    Y_UNIT_TEST(SerializeRoundTrip) {
+        const auto histogram = TEqDepthHistogram::FromSorted<i32>(MakeSkewedValues(10000), 16, 1000000);
+        TStringStream stream;
+        histogram.SerializeTo(stream);
+        UNIT_ASSERT_VALUES_EQUAL(stream.Size(), histogram.GetSerializedSize());
+        const TEqDepthHistogram copy(stream.Data(), stream.Size());
+        UNIT_ASSERT(copy.GetType() == histogram.GetType());
+        UNIT_ASSERT_VALUES_EQUAL(copy.GetNumBuckets(), histogram.GetNumBuckets());
+        UNIT_ASSERT_VALUES_EQUAL(copy.GetEnd<i32>(), histogram.GetEnd<i32>());
+        for (ui32 i = 0; i < histogram.GetNumBuckets(); ++i) {
+            UNIT_ASSERT_VALUES_EQUAL(copy.GetBucketStart<i32>(i), histogram.GetBucketStart<i32>(i));
+            UNIT_ASSERT_VALUES_EQUAL(copy.GetNumElementsInBucket(i), histogram.GetNumElementsInBucket(i));
+            UNIT_ASSERT_VALUES_EQUAL(copy.GetNumDistinctInBucket(i), histogram.GetNumDistinctInBucket(i));
+        }
+        UNIT_ASSERT_EXCEPTION(TEqDepthHistogram(stream.Data(), stream.Size() - 1), yexception);
+    }
+
+    Y_UNIT_TEST(Empty) {
+        const auto histogram = TEqDepthHistogram::FromSorted<i32>({}, 10);
+        UNIT_ASSERT(histogram.Empty());
+        TEqDepthHistogramEstimator estimator(std::make_shared<TEqDepthHistogram>(histogram));
+        UNIT_ASSERT_VALUES_EQUAL(estimator.GetNumElements(), 0);
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateLess<i32>(5), 0);
+    }
+}
+
+} // namespace NKikimr
@@ -0,0 +1,69 @@
+#include <yql/essentials/core/histogram/eq_width_histogram_2d.h>
+
+#include <library/cpp/testing/unittest/registar.h>
+
+#include <util/stream/str.h>
+
+namespace NKikimr {
+
+namespace {
+
+template <typename T>
+TEqWidthHistogram MakeAxis(ui32 numBuckets, T min, T max) {
+    const auto starts = NPrivate::MakeEqWidthStarts<T>(min, max, numBuckets);
+    const TVector<ui64> counts(starts.size());
+    return TEqWidthHistogram(GetHistogramValueType<T>(), TArrayRef<const T>(starts), TArrayRef<const ui64>(counts));
+}
+
+// Pairs (x, x / 10) for every x in [0, 100).
+std::shared_ptr<TEqWidthHistogram2D> MakeCorrelated() {
+    auto histogram = std::make_shared<TEqWidthHistogram2D>(MakeAxis<i32>(10, 0, 99), MakeAxis<double>(10, 0.0, 10.0));
+    for (i32 x = 0; x < 100; ++x) {
+        histogram->AddElement<i32, double>(x, x / 10);
+    }
+    return histogram;
+}
+
+} // namespace
+
+Y_UNIT_TEST_SUITE(EqWidthHistogram2D) {
+    Y_UNIT_TEST(EstimateRange) {
+        TEqWidthHistogram2DEstimator estimator(MakeCorrelated());
+        UNIT_ASSERT_VALUES_EQUAL(estimator.GetNumElements(), 100);
+        // The columns are correlated, so a rectangle off the diagonal is empty.
+        UNIT_ASSERT_VALUES_EQUAL((estimator.EstimateRange<i32, double>(0, 49, 5.0, 9.5)), 0);
+        UNIT_ASSERT_VALUES_EQUAL((estimator.EstimateRange<i32, double>(0, 49, 0.0, 4.5)), 50);
+        UNIT_ASSERT_VALUES_EQUAL((estimator.EstimateRange<i32, double>(20, 79, 0.0, 9.5)), 60);
+        UNIT_ASSERT_VALUES_EQUAL((estimator.EstimateRange<i32, double>(79, 20, 0.0, 9.5)), 0);
+        UNIT_ASSERT_VALUES_EQUAL((estimator.EstimateEqual<i32, double>(15, 1.0)), 1);
+
+        TEqWidthHistogram2DEstimator interpolated(MakeCorrelated(), {.Interpolate = true});
+        UNIT_ASSERT_VALUES_EQUAL((interpolated.EstimateRange<i32, double>(0, 4, 0.0, 0.99)), 5);
+    }
+
+    Y_UNIT_TEST(SerializeRoundTrip) {
+        const auto histogram = MakeCorrelated();
+        TStringStream stream;
+        histogram->SerializeTo(stream);
+        UNIT_ASSERT_VALUES_EQUAL(stream.Size(), histogram->GetSerializedSize());
+        const TEqWidthHistogram2D copy(stream.Data(), stream.Size());
+        UNIT_ASSERT_EXCEPTION(TEqWidthHistogram2D(stream.Data(), stream.Size() - 1), yexception);
+        UNIT_ASSERT(copy.GetXAxis().BucketsEqual<i32>(histogram->GetXAxis()));
+        UNIT_ASSERT(copy.GetYAxis().BucketsEqual<double>(histogram->GetYAxis()));
+        for (ui32 x = 0; x < 10; ++x) {
+            for (ui32 y = 0; y < 10; ++y) {
+                UNIT_ASSERT_VALUES_EQUAL(copy.GetNumElementsInBucket(x, y), histogram->GetNumElementsInBucket(x, y));
+            }
+        }
+    }
+
+    Y_UNIT_TEST(Aggregate) {
+        auto histogram = MakeCorrelated();
+        UNIT_ASSERT((histogram->Aggregate<i32, double>(*MakeCorrelated())));
+        UNIT_ASSERT_VALUES_EQUAL(histogram->GetNumElementsInBucket(3, 3), 20);
+        const TEqWidthHistogram2D other(MakeAxis<i32>(5, 0, 99), MakeAxis<double>(10, 0.0, 10.0));
+        UNIT_ASSERT(!(histogram->Aggregate<i32, double>(other)));
+    }
+}
+
+} // namespace NKikimr
@@ -0,0 +1,215 @@
+#include <yql/essentials/core/histogram/eq_width_histogram_auto_range.h>
+#include <yql/essentials/core/histogram/eq_width_histogram_builder.h>
+#include <yql/essentials/core/histogram/eq_width_histogram_sampling.h>
+
+#include <library/cpp/testing/unittest/registar.h>
+
+#include <util/random/fast.h>
+
+namespace NKikimr {
+
+namespace {
+
+template <typename T>
+TEqWidthHistogram MakeEqWidthHistogram(ui32 numBuckets, T min, T max) {
+    const auto starts = NPrivate::MakeEqWidthStarts<T>(min, max, numBuckets);
+    const TVector<ui64> counts(starts.size());
+    return TEqWidthHistogram(GetHistogramValueType<T>(), TArrayRef<const T>(starts), TArrayRef<const ui64>(counts));
+}
+
+TVector<i32> MakeValues(ui32 numValues, i32 min, i32 max) {
+    TFastRng64 rng(5);
+    TVector<i32> values;
+    for (ui32 i = 0; i < numValues; ++i) {
+        values.push_back(min + static_cast<i32>(rng.Uniform(max - min + 1)));
+    }
+    return values;
+}
+
+void CheckSameCounts(const TEqWidthHistogram& left, const TEqWidthHistogram& right) {
+    UNIT_ASSERT_VALUES_EQUAL(left.GetNumBuckets(), right.GetNumBuckets());
+    for (ui32 i = 0; i < left.GetNumBuckets(); ++i) {
+        UNIT_ASSERT_VALUES_EQUAL(left.GetNumElementsInBucket(i), right.GetNumElementsInBucket(i));
+    }
+}
+
+} // namespace
+
+Y_UNIT_TEST_SUITE(EqWidthHistogramBuilder) {
+    Y_UNIT_TEST(ParallelMatchesSequential) {
+        TThreadPool pool;
+        pool.Start(4);
+        const auto values = MakeValues(1000000, -100, 1100);
+        auto layout = MakeEqWidthHistogram<i32>(64, 0, 999);
+        layout.AddElement<i32>(500);
+        layout.EnableNdv(10);
+        auto sequential = layout;
+        sequential.AddElements<i32>(values);
+        for (const ui32 numParts : {1, 3, 8, 16}) {
+            const auto parallel = BuildEqWidthHistogramParallel<i32>(layout, values, pool, numParts);
+            CheckSameCounts(parallel, sequential);
+            UNIT_ASSERT(parallel.HasNdv());
+            UNIT_ASSERT_VALUES_EQUAL(parallel.GetNdv(), sequential.GetNdv());
+        }
+        pool.Stop();
+    }
+
+    Y_UNIT_TEST(RunInParallelRethrows) {
+        TThreadPool pool;
+        pool.Start(4);
+        std::atomic<ui32> numFinished{0};
+        UNIT_ASSERT_EXCEPTION(NPrivate::RunInParallel(pool, 16, [&](ui32 i) {
+            ++numFinished;
+            if (i % 5 == 3) {
+                ythrow yexception() << "task " << i;
+            }
+        }), yexception);
+        UNIT_ASSERT_VALUES_EQUAL(numFinished.load(), 16);
+    }
+
+    Y_UNIT_TEST(NestedRunInParallel) {
+        // A single worker would deadlock waiting for nested tasks queued behind it.
+        TThreadPool pool;
+        pool.Start(1);
+        const auto values = MakeValues(200000, 0, 999);
+        const auto layout = MakeEqWidthHistogram<i32>(10, 0, 999);
+        auto sequential = layout;
+        sequential.AddElements<i32>(values);
+        TVector<TEqWidthHistogram> nested(2, layout);
+        NPrivate::RunInParallel(pool, 2, [&](ui32 i) {
+            nested[i] = BuildEqWidthHistogramParallel<i32>(layout, values, pool, 4);
+        });
+        for (const auto& histogram : nested) {
+            CheckSameCounts(histogram, sequential);
+        }
+        pool.Stop();
+    }
+
+    Y_UNIT_TEST(SampledCountsAreScaled) {
+        const auto values = MakeValues(100000, 0, 999);
+        auto layout = MakeEqWidthHistogram<i32>(10, 0, 999);
+        layout.EnableNdv();
+        auto exact = layout;
+        exact.AddElements<i32>(values);
+
+        TSampledEqWidthHistogramBuilder<i32> builder(layout, 0.1, 42);
+        builder.AddElements(TArrayRef<const i32>(values).subspan(0, 50000));
+        for (size_t i = 50000; i < values.size(); ++i) {
+            builder.AddElement(values[i]);
+        }
+        UNIT_ASSERT_VALUES_EQUAL(builder.GetNumRows(), values.size());
+        UNIT_ASSERT_DOUBLES_EQUAL(builder.GetNumSampled(), 10000.0, 500.0);
+        const auto sampled = builder.Finish();
+        UNIT_ASSERT(!sampled.HasNdv());
+        const auto counts = sampled.GetCounts();
+        UNIT_ASSERT_VALUES_EQUAL(std::accumulate(counts.begin(), counts.end(), 0ULL), values.size());
+        TEqWidthHistogramEstimator estimator(std::make_shared<TEqWidthHistogram>(sampled), {.SampleRate = builder.GetSampleRate()});
+        for (ui32 i = 0; i < exact.GetNumBuckets(); ++i) {
+            // Within 4 standard errors.
+            const double error = estimator.GetStandardError(exact.GetNumElementsInBucket(i));
+            UNIT_ASSERT_DOUBLES_EQUAL(sampled.GetNumElementsInBucket(i), exact.GetNumElementsInBucket(i), 4 * error);
+        }
+
+        TSampledEqWidthHistogramBuilder<i32> all(layout, 1.0);
+        all.AddElements(values);
+        CheckSameCounts(all.Finish(), exact);
+    }
+
+    Y_UNIT_TEST(AutoRange) {
+        const auto values = MakeValues(10000, -300, 700);
+        TAutoRangeEqWidthHistogramBuilder<i32> builder(1 << 20, 100);
+        UNIT_ASSERT_VALUES_EQUAL(builder.GetMaxNumBuckets(), 100);
+        builder.ObserveElements(values);
+        UNIT_ASSERT(builder.HasRange());
+        builder.AddElements(values);
+        // Out of the observed range.
+        builder.AddElement(5000);
+        const auto histogram = builder.Finish();
+        UNIT_ASSERT(histogram.IsEqWidthLayout());
+        UNIT_ASSERT_VALUES_EQUAL(histogram.GetNumBuckets(), 100);
+        UNIT_ASSERT(!CmpLess<i32>(-300, histogram.GetBucketStart<i32>(0)));
+        const i32 width = histogram.GetBucketStart<i32>(1) - histogram.GetBucketStart<i32>(0);
+        UNIT_ASSERT_LT(5000, histogram.GetBucketStart<i32>(99) + width);
+        const auto counts = histogram.GetCounts();
+        UNIT_ASSERT_VALUES_EQUAL(std::accumulate(counts.begin(), counts.end(), 0ULL), values.size() + 1);
+
+        // The memory budget limits buckets.
+        UNIT_ASSERT_VALUES_EQUAL(TAutoRangeEqWidthHistogramBuilder<i32>(sizeof(TEqWidthHistogram) + 12 * 10).GetMaxNumBuckets(), 10);
+    }
+
+    Y_UNIT_TEST(AutoRangeOfSingleValue) {
+        TAutoRangeEqWidthHistogramBuilder<i32> builder(1 << 20, 100);
+        builder.AddElement(7);
+        const auto histogram = builder.Finish();
+        UNIT_ASSERT(histogram.IsEqWidthLayout());
+        UNIT_ASSERT_VALUES_EQUAL(histogram.GetNumBuckets(), 100);
+        UNIT_ASSERT_VALUES_EQUAL(histogram.GetBucketStart<i32>(0), 7);
+        UNIT_ASSERT_VALUES_EQUAL(histogram.GetBucketStart<i32>(99), 106);
+        UNIT_ASSERT_VALUES_EQUAL(histogram.GetNumElementsInBucket(0), 1);
+
+        // Shifted down at the maximum of the type.
+        TAutoRangeEqWidthHistogramBuilder<ui16> top(1 << 20, 100);
+        top.ObserveRange(65530, 65530);
+        const auto topHistogram = top.Finish();
+        UNIT_ASSERT_VALUES_EQUAL(topHistogram.GetNumBuckets(), 100);
+        UNIT_ASSERT_VALUES_EQUAL(topHistogram.GetBucketStart<ui16>(0), 65436);
+        UNIT_ASSERT_VALUES_EQUAL(topHistogram.GetBucketStart<ui16>(99), 65535);
+
+        for (const double val : {1.5, -3.0, 0.0}) {
+            TAutoRangeEqWidthHistogramBuilder<double> doubles(1 << 20, 100);
+            doubles.AddElement(val);
+            const auto doubleHistogram = doubles.Finish();
+            UNIT_ASSERT(doubleHistogram.IsEqWidthLayout());
+            UNIT_ASSERT_VALUES_EQUAL(doubleHistogram.GetNumBuckets(), 100);
+            UNIT_ASSERT(!CmpLess<double>(val, doubleHistogram.GetBucketStart<double>(0)));
+            UNIT_ASSERT_VALUES_EQUAL(doubleHistogram.GetNumElementsInBucket(0), 1);
+            UNIT_ASSERT_GE(doubleHistogram.GetBucketStart<double>(1) - doubleHistogram.GetBucketStart<double>(0), 1.0 / (1 << 20));
+        }
+        // The width is relative to the magnitude of values rather than adjacent representable values.
+        TAutoRangeEqWidthHistogramBuilder<float> floats(1 << 20, 100);
+        floats.ObserveRange(0.5f, std::nextafter(0.5f, 1.0f));
+        const auto floatHistogram = floats.Finish();
+        UNIT_ASSERT(floatHistogram.IsEqWidthLayout());
+        UNIT_ASSERT_VALUES_EQUAL(floatHistogram.GetNumBuckets(), 100);
+        UNIT_ASSERT_VALUES_EQUAL(floatHistogram.GetBucketStart<float>(0), 0.5f);
+        for (ui32 i = 1; i < 100; ++i) {
+            UNIT_ASSERT_VALUES_EQUAL(floatHistogram.GetBucketStart<float>(i) - floatHistogram.GetBucketStart<float>(i - 1), 1.0f / (1 << 20));
+        }
+        for (const double val : {1e6, -1e6}) {
+            TAutoRangeEqWidthHistogramBuilder<double> large(1 << 20, 100);
+            large.AddElement(val);
+            const auto largeHistogram = large.Finish();
+            UNIT_ASSERT_VALUES_EQUAL(largeHistogram.GetBucketStart<double>(1) - largeHistogram.GetBucketStart<double>(0), 1.0);
+        }
+    }
+
+    Y_UNIT_TEST(AutoRangeGrowsFromSingleValue) {
+        // The range of a single value grows to a distinct value with the width of the same order as
+        // a histogram of both values built at once has.
+        const auto check = [](auto first, auto second) {
+            using T = decltype(first);
+            TAutoRangeEqWidthHistogramBuilder<T> builder(1 << 20, 100);
+            builder.AddElement(first);
+            builder.AddElement(second);
+            const auto histogram = builder.Finish();
+            UNIT_ASSERT(histogram.IsEqWidthLayout());
+            UNIT_ASSERT_VALUES_EQUAL(histogram.GetNumBuckets(), 100);
+            const double width = histogram.template GetBucketStart<T>(1) - histogram.template GetBucketStart<T>(0);
+            UNIT_ASSERT_LE(width, 4 * std::fabs(static_cast<double>(second) - first) / 100);
+            for (ui32 i = 1; i < 100; ++i) {
+                UNIT_ASSERT_VALUES_EQUAL(histogram.template GetBucketStart<T>(i) - histogram.template GetBucketStart<T>(i - 1), width);
+            }
+            const auto counts = histogram.GetCounts();
+            UNIT_ASSERT_VALUES_EQUAL(std::accumulate(counts.begin(), counts.end(), 0ULL), 2);
+            UNIT_ASSERT(histogram.template FindContainingBucketIndex<T>(first) != histogram.template FindContainingBucketIndex<T>(second));
+        };
+        check(0.0, 1.0);
+        check(0.0, -1.0);
+        check(0.0f, 1.0f);
+        check(1.5, 1000.0);
+        check(-3.0f, 3.0f);
+        check(1e-9, 1e-3);
+    }
+}
+
+} // namespace NKikimr
@@ -0,0 +1,94 @@
+#include <yql/essentials/core/histogram/eq_width_histogram_cache.h>
+
+#include <library/cpp/testing/unittest/registar.h>
+
+namespace NKikimr {
+
+namespace {
+
+TEqWidthHistogramEstimatorCache::TEstimatorPtr MakeEstimator(ui32 numBuckets = 10) {
+    auto histogram = std::make_shared<TEqWidthHistogram>(numBuckets, EHistogramValueType::Int32);
+    return std::make_shared<const TEqWidthHistogramEstimator>(histogram);
+}
+
+} // namespace
+
+Y_UNIT_TEST_SUITE(EqWidthHistogramEstimatorCache) {
+    Y_UNIT_TEST(FindAndInsert) {
+        TEqWidthHistogramEstimatorCache cache;
+        UNIT_ASSERT(!cache.Find("table", "column", 1));
+        const auto estimator = MakeEstimator();
+        UNIT_ASSERT_VALUES_EQUAL(cache.Insert("table", "column", 1, estimator), estimator);
+        UNIT_ASSERT_VALUES_EQUAL(cache.Find("table", "column", 1), estimator);
+        UNIT_ASSERT(!cache.Find("table", "column", 2));
+        UNIT_ASSERT(!cache.Find("table", "other", 1));
+        UNIT_ASSERT_VALUES_EQUAL(cache.GetNumEntries(), 1);
+        UNIT_ASSERT_VALUES_EQUAL(cache.GetSize(), estimator->GetAllocatedSize());
+
+        // The first one of the same version is kept.
+        UNIT_ASSERT_VALUES_EQUAL(cache.Insert("table", "column", 1, MakeEstimator()), estimator);
+
+        // A newer version replaces the entry.
+        const auto newer = MakeEstimator();
+        UNIT_ASSERT_VALUES_EQUAL(cache.Insert("table", "column", 2, newer), newer);
+        UNIT_ASSERT(!cache.Find("table", "column", 1));
+        UNIT_ASSERT_VALUES_EQUAL(cache.Find("table", "column", 2), newer);
+        UNIT_ASSERT_VALUES_EQUAL(cache.GetNumEntries(), 1);
+
+        // An older version does not replace the entry, the newer one is returned.
+        UNIT_ASSERT_VALUES_EQUAL(cache.Insert("table", "column", 1, MakeEstimator()), newer);
+        UNIT_ASSERT_VALUES_EQUAL(cache.Find("table", "column", 2), newer);
+
+        cache.Invalidate("table", "column");
+        UNIT_ASSERT(!cache.Find("table", "column", 2));
+        UNIT_ASSERT_VALUES_EQUAL(cache.GetNumEntries(), 0);
+        UNIT_ASSERT_VALUES_EQUAL(cache.GetSize(), 0);
+    }
+
+    Y_UNIT_TEST(FindOrCreate) {
+        TEqWidthHistogramEstimatorCache cache;
+        ui32 numCreated = 0;
+        const auto create = [&]() {
+            ++numCreated;
+            return MakeEstimator();
+        };
+        const auto estimator = cache.FindOrCreate("table", "column", 1, create);
+        UNIT_ASSERT_VALUES_EQUAL(cache.FindOrCreate("table", "column", 1, create), estimator);
+        UNIT_ASSERT_VALUES_EQUAL(numCreated, 1);
+    }
+
+    Y_UNIT_TEST(EvictsLeastRecentlyUsed) {
+        const ui64 size = MakeEstimator()->GetAllocatedSize();
+        TEqWidthHistogramEstimatorCache cache(3 * size, 1);
+        for (const auto column : {"a", "b", "c"}) {
+            cache.Insert("table", column, 1, MakeEstimator());
+        }
+        UNIT_ASSERT(cache.Find("table", "a", 1));
+        cache.Insert("table", "d", 1, MakeEstimator());
+        UNIT_ASSERT_VALUES_EQUAL(cache.GetNumEntries(), 3);
+        UNIT_ASSERT_LE(cache.GetSize(), cache.GetMaxSize());
+        UNIT_ASSERT(cache.Find("table", "a", 1));
+        UNIT_ASSERT(!cache.Find("table", "b", 1));
+        UNIT_ASSERT(cache.Find("table", "d", 1));
+
+        cache.Clear();
+        UNIT_ASSERT_VALUES_EQUAL(cache.GetNumEntries(), 0);
+    }
+
+    Y_UNIT_TEST(KeepsInsertedIfOthersAreUsed) {
+        const ui64 size = MakeEstimator()->GetAllocatedSize();
+        TEqWidthHistogramEstimatorCache cache(2 * size, 1);
+        for (const auto column : {"a", "b"}) {
+            cache.Insert("table", column, 1, MakeEstimator());
+            UNIT_ASSERT(cache.Find("table", column, 1));
+        }
+        // Both used entries get a second chance, then the oldest one is evicted.
+        cache.Insert("table", "c", 1, MakeEstimator());
+        UNIT_ASSERT_VALUES_EQUAL(cache.GetNumEntries(), 2);
+        UNIT_ASSERT(!cache.Find("table", "a", 1));
+        UNIT_ASSERT(cache.Find("table", "b", 1));
+        UNIT_ASSERT(cache.Find("table", "c", 1));
+    }
+}
+
+} // namespace NKikimr
@@ -0,0 +1,79 @@
+#include <yql/essentials/core/histogram/eq_width_histogram_compact.h>
+
+#include <library/cpp/testing/unittest/registar.h>
+
+#include <util/stream/str.h>
+
+namespace NKikimr {
+
+namespace {
+
+TEqWidthHistogram MakeHistogram(ui64 count) {
+    const auto starts = NPrivate::MakeEqWidthStarts<i64>(0, 999, 10);
+    const TVector<ui64> counts(starts.size(), count);
+    return TEqWidthHistogram(EHistogramValueType::Int64, TArrayRef<const i64>(starts), TArrayRef<const ui64>(counts));
+}
+
+void CheckEqual(const TCompactEqWidthHistogram& compact, const TEqWidthHistogram& histogram) {
+    UNIT_ASSERT(compact.GetType() == histogram.GetType());
+    UNIT_ASSERT_VALUES_EQUAL(compact.GetNumBuckets(), histogram.GetNumBuckets());
+    for (ui32 i = 0; i < histogram.GetNumBuckets(); ++i) {
+        UNIT_ASSERT_VALUES_EQUAL(compact.GetBucketStart<i64>(i), histogram.GetBucketStart<i64>(i));
+        UNIT_ASSERT_VALUES_EQUAL(compact.GetNumElementsInBucket(i), histogram.GetNumElementsInBucket(i));
+    }
+}
+
+} // namespace
+
+Y_UNIT_TEST_SUITE(CompactEqWidthHistogram) {
+    Y_UNIT_TEST(CountSize) {
+        UNIT_ASSERT_VALUES_EQUAL(TCompactEqWidthHistogram(MakeHistogram(100)).GetCountSize(), sizeof(ui16));
+        UNIT_ASSERT_VALUES_EQUAL(TCompactEqWidthHistogram(MakeHistogram(100000)).GetCountSize(), sizeof(ui32));
+        UNIT_ASSERT_VALUES_EQUAL(TCompactEqWidthHistogram(MakeHistogram(1ULL << 40)).GetCountSize(), sizeof(ui64));
+        UNIT_ASSERT_LT(TCompactEqWidthHistogram(MakeHistogram(100)).GetAllocatedSize(), MakeHistogram(100).GetAllocatedSize());
+    }
+
+    Y_UNIT_TEST(CountSizeIsPromoted) {
+        auto histogram = MakeHistogram(std::numeric_limits<ui16>::max() - 1);
+        TCompactEqWidthHistogram compact(histogram);
+        UNIT_ASSERT_VALUES_EQUAL(compact.AddElement<i64>(105), 1);
+        histogram.AddElement<i64>(105);
+        UNIT_ASSERT_VALUES_EQUAL(compact.GetCountSize(), sizeof(ui16));
+        compact.AddElement<i64>(-5);
+        compact.AddElement<i64>(-5);
+        histogram.AddToBucket(0, 2);
+        UNIT_ASSERT_VALUES_EQUAL(compact.GetCountSize(), sizeof(ui32));
+        compact.AddToBucket(9, 1ULL << 33);
+        histogram.AddToBucket(9, 1ULL << 33);
+        UNIT_ASSERT_VALUES_EQUAL(compact.GetCountSize(), sizeof(ui64));
+        CheckEqual(compact, histogram);
+    }
+
+    Y_UNIT_TEST(SerializeRoundTrip) {
+        for (const ui64 count : {100ULL, 100000ULL, 1ULL << 40}) {
+            const TCompactEqWidthHistogram compact(MakeHistogram(count));
+            TStringStream stream;
+            compact.SerializeTo(stream);
+            UNIT_ASSERT_VALUES_EQUAL(stream.Size(), compact.GetSerializedSize());
+            const TCompactEqWidthHistogram copy(stream.Data(), stream.Size());
+            UNIT_ASSERT_VALUES_EQUAL(copy.GetCountSize(), compact.GetCountSize());
+            CheckEqual(copy, MakeHistogram(count));
+            CheckEqual(copy, copy.ToHistogram());
+            UNIT_ASSERT_EXCEPTION(TCompactEqWidthHistogram(stream.Data(), stream.Size() - 1), yexception);
+        }
+    }
+
+    Y_UNIT_TEST(EstimatedThroughHistogram) {
+        // The compact form is not estimated over, estimates are of the converted histogram.
+        auto histogram = MakeHistogram(100);
+        histogram.AddToBucket(3, 1000);
+        const TEqWidthHistogramEstimator expected(std::make_shared<TEqWidthHistogram>(histogram));
+        const TEqWidthHistogramEstimator estimator(std::make_shared<TEqWidthHistogram>(TCompactEqWidthHistogram(histogram).ToHistogram()));
+        for (i64 val = -50; val < 1100; val += 50) {
+            UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateLessOrEqual<i64>(val), expected.EstimateLessOrEqual<i64>(val));
+            UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateEqual<i64>(val), expected.EstimateEqual<i64>(val));
+        }
+    }
+}
+
+} // namespace NKikimr
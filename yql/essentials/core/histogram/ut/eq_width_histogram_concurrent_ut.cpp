@@ -0,0 +1,85 @@
+#include <yql/essentials/core/histogram/eq_width_histogram_concurrent.h>
+
+#include <library/cpp/testing/unittest/registar.h>
+
+#include <thread>
+
+namespace NKikimr {
+
+namespace {
+
+TEqWidthHistogram MakeLayout() {
+    const auto starts = NPrivate::MakeEqWidthStarts<i32>(0, 999, 100);
+    const TVector<ui64> counts(starts.size(), 1);
+    return TEqWidthHistogram(EHistogramValueType::Int32, TArrayRef<const i32>(starts), TArrayRef<const ui64>(counts));
+}
+
+} // namespace
+
+Y_UNIT_TEST_SUITE(ConcurrentEqWidthHistogram) {
+    Y_UNIT_TEST(ConcurrentAdds) {
+        constexpr ui32 numThreads = 8;
+        constexpr i32 numValues = 20000;
+        for (const ui32 numStripes : {1, 4}) {
+            auto layout = MakeLayout();
+            layout.EnableNdv();
+            TConcurrentEqWidthHistogram histogram(layout, numStripes);
+            TVector<std::thread> threads;
+            for (ui32 t = 0; t < numThreads; ++t) {
+                threads.emplace_back([&histogram, t]() {
+                    TVector<i32> batch;
+                    for (i32 val = 0; val < numValues; ++val) {
+                        const i32 shifted = (val * 7 + static_cast<i32>(t)) % 1200 - 100;
+                        if (t % 2) {
+                            histogram.AddElement<i32>(shifted);
+                            continue;
+                        }
+                        batch.push_back(shifted);
+                        if (batch.size() == 100) {
+                            histogram.AddElements<i32>(batch);
+                            batch.clear();
+                        }
+                    }
+                    histogram.AddElements<i32>(batch);
+                });
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+
+            auto expected = MakeLayout();
+            for (ui32 t = 0; t < numThreads; ++t) {
+                for (i32 val = 0; val < numValues; ++val) {
+                    expected.AddElement<i32>((val * 7 + static_cast<i32>(t)) % 1200 - 100);
+                }
+            }
+            const auto snapshot = histogram.Snapshot();
+            UNIT_ASSERT(!snapshot.HasNdv());
+            UNIT_ASSERT(snapshot.BucketsEqual<i32>(expected));
+            for (ui32 i = 0; i < expected.GetNumBuckets(); ++i) {
+                UNIT_ASSERT_VALUES_EQUAL(snapshot.GetNumElementsInBucket(i), expected.GetNumElementsInBucket(i));
+            }
+        }
+    }
+
+    Y_UNIT_TEST(BatchesOfDifferentHistograms) {
+        const auto wideStarts = NPrivate::MakeEqWidthStarts<i32>(0, 9999, 1000);
+        const TVector<ui64> wideCounts(wideStarts.size());
+        TConcurrentEqWidthHistogram narrow(MakeLayout());
+        TConcurrentEqWidthHistogram wide(TEqWidthHistogram(EHistogramValueType::Int32, TArrayRef<const i32>(wideStarts), TArrayRef<const ui64>(wideCounts)));
+        const TVector<i32> values = {5, 5, 995, 9995, -1};
+        for (ui32 i = 0; i < 3; ++i) {
+            narrow.AddElements<i32>(values);
+            wide.AddElements<i32>(values);
+        }
+        const auto narrowSnapshot = narrow.Snapshot();
+        UNIT_ASSERT_VALUES_EQUAL(narrowSnapshot.GetNumElementsInBucket(0), 1 + 9);
+        UNIT_ASSERT_VALUES_EQUAL(narrowSnapshot.GetNumElementsInBucket(99), 1 + 6);
+        const auto wideSnapshot = wide.Snapshot();
+        UNIT_ASSERT_VALUES_EQUAL(wideSnapshot.GetNumElementsInBucket(0), 9);
+        UNIT_ASSERT_VALUES_EQUAL(wideSnapshot.GetNumElementsInBucket(99), 3);
+        UNIT_ASSERT_VALUES_EQUAL(wideSnapshot.GetNumElementsInBucket(999), 3);
+    }
+}
+
+} // namespace NKikimr
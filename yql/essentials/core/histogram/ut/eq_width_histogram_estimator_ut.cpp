@@ -0,0 +1,330 @@
+#include <yql/essentials/core/histogram/eq_width_histogram.h>
+#include <yql/essentials/core/histogram/memory_pool_resource.h>
+
+#include <library/cpp/testing/unittest/registar.h>
+
+#include <util/random/fast.h>
+
+namespace NKikimr {
+
+namespace {
+
+using TSettings = TEqWidthHistogramEstimator::TSettings;
+using EMode = TEqWidthHistogramEstimator::EMode;
+
+template <typename T>
+std::shared_ptr<TEqWidthHistogram> MakeHistogram(TVector<T> starts, EHistogramValueType type = GetHistogramValueType<T>()) {
+    const TVector<ui64> counts(starts.size());
+    return std::make_shared<TEqWidthHistogram>(type, TArrayRef<const T>(starts), TArrayRef<const ui64>(counts));
+}
+
+template <typename T>
+std::shared_ptr<TEqWidthHistogram> MakeEqWidthHistogram(ui32 numBuckets, T min, T max) {
+    return MakeHistogram<T>(NPrivate::MakeEqWidthStarts<T>(min, max, numBuckets));
+}
+
+// Values of a skewed column in [0, 1000), sorted.
+TVector<i32> MakeSkewedValues(ui32 numValues) {
+    TFastRng64 rng(7);
+    TVector<i32> values;
+    for (ui32 i = 0; i < numValues; ++i) {
+        const double x = rng.GenRandReal3();
+        values.push_back(static_cast<i32>(1000 * x * x));
+    }
+    std::sort(values.begin(), values.end());
+    return values;
+}
+
+// Values to estimate: every start of a bucket, its neighbours and values out of the range.
+template <typename T>
+TVector<T> MakeProbes(const TEqWidthHistogram& histogram) {
+    TVector<T> probes;
+    for (ui32 i = 0; i < histogram.GetNumBuckets(); ++i) {
+        const T start = histogram.GetBucketStart<T>(i);
+        probes.push_back(start);
+        probes.push_back(start - 1);
+        probes.push_back(start + 1);
+        probes.push_back(start + 7);
+    }
+    probes.push_back(-100);
+    probes.push_back(5000);
+    return probes;
+}
+
+ui64 CountLess(const TVector<i32>& sorted, i32 val) {
+    return std::lower_bound(sorted.begin(), sorted.end(), val) - sorted.begin();
+}
+ui64 CountLessOrEqual(const TVector<i32>& sorted, i32 val) {
+    return std::upper_bound(sorted.begin(), sorted.end(), val) - sorted.begin();
+}
+
+void CheckBounds(const TEqWidthHistogramEstimator::TBoundedEstimate& estimate, ui64 exact) {
+    UNIT_ASSERT_LE(estimate.Lower, exact);
+    UNIT_ASSERT_LE(exact, estimate.Upper);
+    UNIT_ASSERT_LE(estimate.Lower, estimate.Estimate);
+    UNIT_ASSERT_LE(estimate.Estimate, estimate.Upper);
+}
+
+template <typename T>
+void CheckSameEstimates(const TEqWidthHistogramEstimator& left, const TEqWidthHistogramEstimator& right, const TVector<T>& probes) {
+    UNIT_ASSERT_VALUES_EQUAL(left.GetNumElements(), right.GetNumElements());
+    for (const auto val : probes) {
+        UNIT_ASSERT_VALUES_EQUAL(left.EstimateLessOrEqual<T>(val), right.EstimateLessOrEqual<T>(val));
+        UNIT_ASSERT_VALUES_EQUAL(left.EstimateLess<T>(val), right.EstimateLess<T>(val));
+        UNIT_ASSERT_VALUES_EQUAL(left.EstimateGreaterOrEqual<T>(val), right.EstimateGreaterOrEqual<T>(val));
+        UNIT_ASSERT_VALUES_EQUAL(left.EstimateGreater<T>(val), right.EstimateGreater<T>(val));
+        UNIT_ASSERT_VALUES_EQUAL(left.EstimateEqual<T>(val), right.EstimateEqual<T>(val));
+        UNIT_ASSERT_VALUES_EQUAL(left.EstimateRange<T>(val, val + 100), right.EstimateRange<T>(val, val + 100));
+    }
+}
+
+template <typename T>
+void CheckBatchMatchesScalar(const TEqWidthHistogramEstimator& estimator, const TVector<T>& probes) {
+    TVector<ui64> result(probes.size());
+    const auto check = [&](auto&& scalar) {
+        for (size_t i = 0; i < probes.size(); ++i) {
+            UNIT_ASSERT_VALUES_EQUAL(result[i], scalar(probes[i]));
+        }
+    };
+    estimator.EstimateLessOrEqualBatch<T>(probes, result);
+    check([&](T val) { return estimator.EstimateLessOrEqual<T>(val); });
+    estimator.EstimateLessBatch<T>(probes, result);
+    check([&](T val) { return estimator.EstimateLess<T>(val); });
+    estimator.EstimateGreaterOrEqualBatch<T>(probes, result);
+    check([&](T val) { return estimator.EstimateGreaterOrEqual<T>(val); });
+    estimator.EstimateGreaterBatch<T>(probes, result);
+    check([&](T val) { return estimator.EstimateGreater<T>(val); });
+    estimator.EstimateEqualBatch<T>(probes, result);
+    check([&](T val) { return estimator.EstimateEqual<T>(val); });
+}
+
+} // namespace
+
+Y_UNIT_TEST_SUITE(EqWidthHistogramEstimator) {
+    Y_UNIT_TEST(Estimates) {
+        auto histogram = MakeEqWidthHistogram<i32>(10, 0, 99);
+        for (i32 val = 0; val < 100; ++val) {
+            histogram->AddElement<i32>(val);
+        }
+        TEqWidthHistogramEstimator estimator(histogram);
+        UNIT_ASSERT_VALUES_EQUAL(estimator.GetNumElements(), 100);
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateLessOrEqual<i32>(50), 60);
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateLess<i32>(50), 50);
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateGreaterOrEqual<i32>(50), 50);
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateGreater<i32>(50), 60);
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateEqual<i32>(55), 1);
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateRange<i32>(20, 39), 30);
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateRange<i32>(39, 20), 0);
+    }
+
+    Y_UNIT_TEST(InterpolatedEstimates) {
+        auto histogram = MakeEqWidthHistogram<i32>(10, 0, 99);
+        for (i32 val = 0; val < 100; ++val) {
+            histogram->AddElement<i32>(val);
+        }
+        TEqWidthHistogramEstimator estimator(histogram, TSettings{.Interpolate = true});
+        // Values are uniform, so interpolated estimates are exact.
+        for (i32 val = 0; val < 100; ++val) {
+            UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateLess<i32>(val), val);
+            UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateLessOrEqual<i32>(val), val + 1);
+            UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateGreater<i32>(val), 99 - val);
+        }
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateRange<i32>(5, 14), 10);
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateLess<i32>(-5), 0);
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateLessOrEqual<i32>(500), 100);
+    }
+
+    Y_UNIT_TEST(StaticAndIncrementalAgree) {
+        for (const bool interpolate : {false, true}) {
+            for (auto histogram : {MakeEqWidthHistogram<i32>(16, 0, 999), MakeHistogram<i32>({0, 10, 50, 100, 400, 900})}) {
+                const auto values = MakeSkewedValues(5000);
+                histogram->AddElements<i32>(values);
+                const auto other = *histogram;
+                auto copy = std::make_shared<TEqWidthHistogram>(*histogram);
+                TEqWidthHistogramEstimator incremental(histogram, TSettings{.Mode = EMode::Incremental, .Interpolate = interpolate});
+                TEqWidthHistogramEstimator fixed(copy, TSettings{.Mode = EMode::Static, .Interpolate = interpolate});
+                const auto probes = MakeProbes<i32>(*histogram);
+                CheckSameEstimates<i32>(incremental, fixed, probes);
+
+                // Updates by both estimators.
+                for (const auto val : MakeSkewedValues(1000)) {
+                    incremental.AddElement<i32>(val);
+                    fixed.AddElement<i32>(val);
+                }
+                CheckSameEstimates<i32>(incremental, fixed, probes);
+                incremental.Aggregate<i32>(other);
+                fixed.Aggregate<i32>(other);
+                CheckSameEstimates<i32>(incremental, fixed, probes);
+
+                // Updates of the histogram, then refresh.
+                TEqWidthHistogramEstimator refreshed(*copy, TSettings{.Mode = EMode::Incremental, .Interpolate = interpolate});
+                CheckSameEstimates<i32>(refreshed, fixed, probes);
+            }
+        }
+    }
+
+    Y_UNIT_TEST(BoundsContainExact) {
+        const auto values = MakeSkewedValues(10000);
+        for (const bool interpolate : {false, true}) {
+            for (auto histogram : {MakeEqWidthHistogram<i32>(16, 0, 999), MakeEqWidthHistogram<i32>(100, 100, 599),
+                                   MakeHistogram<i32>({0, 10, 50, 100, 400, 900})}) {
+                histogram->AddElements<i32>(values);
+                TEqWidthHistogramEstimator estimator(histogram, TSettings{.Interpolate = interpolate});
+                for (const auto val : MakeProbes<i32>(*histogram)) {
+                    const ui64 less = CountLess(values, val);
+                    const ui64 lessOrEqual = CountLessOrEqual(values, val);
+                    CheckBounds(estimator.EstimateLessWithBounds<i32>(val), less);
+                    CheckBounds(estimator.EstimateLessOrEqualWithBounds<i32>(val), lessOrEqual);
+                    CheckBounds(estimator.EstimateGreaterWithBounds<i32>(val), values.size() - lessOrEqual);
+                    CheckBounds(estimator.EstimateGreaterOrEqualWithBounds<i32>(val), values.size() - less);
+                    CheckBounds(estimator.EstimateEqualWithBounds<i32>(val), lessOrEqual - less);
+                    for (const i32 width : {0, 1, 10, 333}) {
+                        CheckBounds(estimator.EstimateRangeWithBounds<i32>(val, val + width), CountLessOrEqual(values, val + width) - less);
+                    }
+                }
+            }
+        }
+    }
+
+    Y_UNIT_TEST(BatchMatchesScalar) {
+        for (const bool interpolate : {false, true}) {
+            for (auto histogram : {MakeEqWidthHistogram<i32>(16, 0, 999), MakeHistogram<i32>({0, 10, 50, 100, 400, 900})}) {
+                histogram->AddElements<i32>(MakeSkewedValues(5000));
+                TEqWidthHistogramEstimator estimator(histogram, TSettings{.Interpolate = interpolate});
+                CheckBatchMatchesScalar<i32>(estimator, MakeProbes<i32>(*histogram));
+            }
+        }
+        auto doubles = MakeEqWidthHistogram<double>(16, -1.0, 1.0);
+        for (ui32 i = 0; i < 1000; ++i) {
+            doubles->AddElement<double>(i / 500.0 - 1);
+        }
+        TEqWidthHistogramEstimator estimator(doubles, TSettings{.Interpolate = true});
+        CheckBatchMatchesScalar<double>(estimator, {-2.0, -1.0, -0.5, 0.0, 0.125, 0.3, 1.0, 2.0});
+    }
+
+    Y_UNIT_TEST(NonOwningEstimator) {
+        auto histogram = MakeEqWidthHistogram<i32>(16, 0, 999);
+        histogram->AddElements<i32>(MakeSkewedValues(5000));
+        TEqWidthHistogramEstimator owning(histogram);
+        TEqWidthHistogramEstimator borrowing(*histogram, TSettings());
+        CheckSameEstimates<i32>(owning, borrowing, MakeProbes<i32>(*histogram));
+        UNIT_ASSERT_LT(borrowing.GetAllocatedSize(), owning.GetAllocatedSize());
+    }
+
+    Y_UNIT_TEST(MemoryPoolResource) {
+        TMemoryPool pool(1024);
+        TMemoryPoolResource resource(pool);
+        const auto starts = NPrivate::MakeEqWidthStarts<i32>(0, 9999, 1000);
+        const TVector<ui64> counts(starts.size());
+        const auto initial = pool.MemoryAllocated();
+        TEqWidthHistogram histogram(EHistogramValueType::Int32, TArrayRef<const i32>(starts), TArrayRef<const ui64>(counts), &resource);
+        const auto withHistogram = pool.MemoryAllocated();
+        UNIT_ASSERT_GE(withHistogram, initial + starts.size() * (sizeof(i32) + sizeof(ui64)));
+        histogram.AddElements<i32>(MakeSkewedValues(5000));
+
+        TEqWidthHistogramEstimator pooled(histogram, TSettings(), &resource);
+        // Prefix sums of counts.
+        UNIT_ASSERT_GE(pool.MemoryAllocated(), withHistogram + starts.size() * sizeof(ui64));
+        const TEqWidthHistogramEstimator heap(std::make_shared<TEqWidthHistogram>(histogram));
+        CheckSameEstimates<i32>(pooled, heap, MakeProbes<i32>(histogram));
+    }
+
+    Y_UNIT_TEST(EqualByNdv) {
+        auto histogram = MakeEqWidthHistogram<i32>(10, 0, 999);
+        histogram->EnableNdv(12, 8);
+        // 10 distinct values per bucket, 10 rows each.
+        for (ui32 repeat = 0; repeat < 10; ++repeat) {
+            for (i32 val = 0; val < 1000; val += 10) {
+                histogram->AddElement<i32>(val);
+            }
+        }
+        TEqWidthHistogramEstimator estimator(histogram);
+        for (i32 val = 0; val < 1000; val += 10) {
+            UNIT_ASSERT_DOUBLES_EQUAL(estimator.EstimateEqual<i32>(val + 5), 10.0, 2.0);
+        }
+        histogram->DisableNdv();
+        estimator.Refresh();
+        // All values of a bucket are assumed to be present.
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateEqual<i32>(5), 1);
+    }
+
+    Y_UNIT_TEST(EqualUsesContainingBucket) {
+        auto histogram = MakeHistogram<i32>({0, 10, 100});
+        for (i32 val = 0; val < 100; ++val) {
+            histogram->AddElement<i32>(val);
+            if (val >= 10) {
+                histogram->AddToBucket(1, 9);
+            }
+        }
+        TEqWidthHistogramEstimator estimator(histogram);
+        // 10 of the first bucket, rather than 900 of the next one, over the width of 10.
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateEqual<i32>(5), 1);
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateEqual<i32>(10), 90);
+        TVector<ui64> result(2);
+        estimator.EstimateEqualBatch<i32>(TVector<i32>{5, 10}, result);
+        UNIT_ASSERT_VALUES_EQUAL(result[0], 1);
+        UNIT_ASSERT_VALUES_EQUAL(result[1], 90);
+        // Bounds and the estimate are of the same bucket.
+        for (const auto& [val, estimate, upper] : {std::tuple<i32, ui64, ui64>{5, 1, 10}, {10, 90, 900}}) {
+            const auto bounded = estimator.EstimateEqualWithBounds<i32>(val);
+            UNIT_ASSERT_VALUES_EQUAL(bounded.Estimate, estimate);
+            UNIT_ASSERT_VALUES_EQUAL(bounded.Lower, 0);
+            UNIT_ASSERT_VALUES_EQUAL(bounded.Upper, upper);
+        }
+    }
+
+    Y_UNIT_TEST(UnknownNdvIsNotUsed) {
+        auto histogram = MakeEqWidthHistogram<i32>(10, 0, 999);
+        histogram->EnableNdv(10, 4);
+        // Counts without values, so sketches are empty.
+        histogram->AddToBucket(0, 1000);
+        TEqWidthHistogramEstimator estimator(histogram);
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateEqual<i32>(5), 10);
+        histogram->EnableNdv(10);
+        estimator.Refresh();
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateEqual<i32>(5), 10);
+    }
+
+    Y_UNIT_TEST(QuantilesAndSplitPoints) {
+        auto histogram = MakeEqWidthHistogram<i32>(10, 0, 999);
+        for (i32 val = 0; val < 1000; ++val) {
+            histogram->AddElement<i32>(val);
+        }
+        TEqWidthHistogramEstimator estimator(histogram);
+        UNIT_ASSERT_VALUES_EQUAL(estimator.GetQuantile<i32>(0), 0);
+        UNIT_ASSERT_VALUES_EQUAL(estimator.GetQuantile<i32>(0.5), 500);
+        UNIT_ASSERT_VALUES_EQUAL(estimator.GetQuantile<i32>(0.25), 250);
+        UNIT_ASSERT(estimator.GetSplitPoints<i32>(4) == TVector<i32>({250, 500, 750}));
+        UNIT_ASSERT(estimator.GetSplitPoints<i32>(1).empty());
+
+        // Skewed values, parts are of the same size.
+        auto skewed = MakeEqWidthHistogram<i32>(100, 0, 999);
+        const auto values = MakeSkewedValues(100000);
+        skewed->AddElements<i32>(values);
+        TEqWidthHistogramEstimator skewedEstimator(skewed);
+        const auto points = skewedEstimator.GetSplitPoints<i32>(8);
+        UNIT_ASSERT_VALUES_EQUAL(points.size(), 7);
+        for (ui32 i = 0; i < points.size(); ++i) {
+            UNIT_ASSERT_DOUBLES_EQUAL(CountLess(values, points[i]), (i + 1) * values.size() / 8.0, values.size() * 0.01);
+        }
+    }
+
+    Y_UNIT_TEST(Empty) {
+        auto histogram = MakeEqWidthHistogram<i32>(10, 0, 99);
+        TEqWidthHistogramEstimator estimator(histogram, TSettings{.Interpolate = true});
+        UNIT_ASSERT_VALUES_EQUAL(estimator.GetNumElements(), 0);
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateLess<i32>(50), 0);
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateRange<i32>(0, 99), 0);
+        UNIT_ASSERT(estimator.GetSplitPoints<i32>(4).empty());
+    }
+
+    Y_UNIT_TEST(SampledStandardError) {
+        auto histogram = MakeEqWidthHistogram<i32>(10, 0, 99);
+        TEqWidthHistogramEstimator full(histogram);
+        UNIT_ASSERT_VALUES_EQUAL(full.GetStandardError(100), 0.0);
+        TEqWidthHistogramEstimator sampled(histogram, TSettings{.SampleRate = 0.5});
+        UNIT_ASSERT_DOUBLES_EQUAL(sampled.GetStandardError(100), 10.0, 1e-9);
+    }
+}
+
+} // namespace NKikimr
@@ -0,0 +1,459 @@
+#include <yql/essentials/core/histogram/eq_width_histogram.h>
+#include <yql/essentials/core/histogram/eq_width_histogram_typed.h>
+
+#include <library/cpp/testing/unittest/registar.h>
+
+#include <util/random/fast.h>
+#include <util/stream/str.h>
+
+namespace NKikimr {
+
+namespace {
+
+template <typename T>
+TEqWidthHistogram MakeHistogram(TVector<T> starts, EHistogramValueType type = GetHistogramValueType<T>()) {
+    const TVector<ui64> counts(starts.size());
+    return TEqWidthHistogram(type, TArrayRef<const T>(starts), TArrayRef<const ui64>(counts));
+}
+
+template <typename T>
+TEqWidthHistogram MakeEqWidthHistogram(ui32 numBuckets, T min, T max) {
+    return MakeHistogram<T>(NPrivate::MakeEqWidthStarts<T>(min, max, numBuckets));
+}
+
+// Returns `numValues` random values in [min, max] and the starts of all buckets of `histogram`.
+template <typename T>
+TVector<T> MakeValues(const TEqWidthHistogram& histogram, ui32 numValues, T min, T max, ui64 seed = 1) {
+    TFastRng64 rng(seed);
+    TVector<T> values;
+    for (ui32 i = 0; i < numValues; ++i) {
+        if constexpr (std::is_floating_point_v<T>) {
+            values.push_back(static_cast<T>(min + (max - min) * rng.GenRandReal3()));
+        } else {
+            // The full range of 64 bit values does not fit `Uniform()`.
+            const ui64 range = NPrivate::ValueDiff<T>(max, min) + 1;
+            values.push_back(static_cast<T>(static_cast<ui64>(min) + (range ? rng.Uniform(range) : rng.GenRand())));
+        }
+    }
+    for (ui32 i = 0; i < histogram.GetNumBuckets(); ++i) {
+        values.push_back(histogram.GetBucketStart<T>(i));
+    }
+    return values;
+}
+
+template <typename T>
+void CheckAddElementsMatchesAddElement(TEqWidthHistogram layout, T min, T max) {
+    const auto values = MakeValues<T>(layout, 10000, min, max);
+    TEqWidthHistogram single(layout);
+    for (const auto val : values) {
+        single.AddElement<T>(val);
+    }
+    TEqWidthHistogram batch(layout);
+    batch.AddElements<T>(values);
+    // Small batches take a different path.
+    TEqWidthHistogram small(layout);
+    for (size_t i = 0; i < values.size(); i += 3) {
+        small.AddElements<T>(TArrayRef<const T>(values).subspan(i, std::min<size_t>(3, values.size() - i)));
+    }
+    for (ui32 i = 0; i < layout.GetNumBuckets(); ++i) {
+        UNIT_ASSERT_VALUES_EQUAL(single.GetNumElementsInBucket(i), batch.GetNumElementsInBucket(i));
+        UNIT_ASSERT_VALUES_EQUAL(single.GetNumElementsInBucket(i), small.GetNumElementsInBucket(i));
+    }
+}
+
+template <typename T>
+void CheckBucketIndices(const TEqWidthHistogram& histogram, T min, T max) {
+    const auto starts = histogram.GetStarts<T>();
+    for (const auto val : MakeValues<T>(histogram, 1000, min, max)) {
+        const ui32 lowerBound = std::lower_bound(starts.begin(), starts.end(), val, CmpLess<T>) - starts.begin();
+        UNIT_ASSERT_VALUES_EQUAL(histogram.FindBucketIndex<T>(val), std::min<ui32>(lowerBound, starts.size() - 1));
+        const ui32 upperBound = std::upper_bound(starts.begin(), starts.end(), val, CmpLess<T>) - starts.begin();
+        UNIT_ASSERT_VALUES_EQUAL(histogram.FindContainingBucketIndex<T>(val), upperBound ? upperBound - 1 : 0);
+        UNIT_ASSERT_VALUES_EQUAL(histogram.GetContainingBucketIndex<T>(histogram.FindBucketIndex<T>(val), val), upperBound ? upperBound - 1 : 0);
+    }
+}
+
+void CheckEqual(const TEqWidthHistogram& left, const TEqWidthHistogram& right) {
+    UNIT_ASSERT(left.GetType() == right.GetType());
+    UNIT_ASSERT_VALUES_EQUAL(left.GetNumBuckets(), right.GetNumBuckets());
+    UNIT_ASSERT_VALUES_EQUAL(left.IsEqWidthLayout(), right.IsEqWidthLayout());
+    VisitHistogramValueType(left.GetType(), [&](auto tag) {
+        using T = typename decltype(tag)::type;
+        UNIT_ASSERT(left.BucketsEqual<T>(right));
+    });
+    for (ui32 i = 0; i < left.GetNumBuckets(); ++i) {
+        UNIT_ASSERT_VALUES_EQUAL(left.GetNumElementsInBucket(i), right.GetNumElementsInBucket(i));
+    }
+    UNIT_ASSERT_VALUES_EQUAL(left.HasNdv(), right.HasNdv());
+    UNIT_ASSERT_VALUES_EQUAL(left.HasBucketNdv(), right.HasBucketNdv());
+    if (left.HasNdv()) {
+        UNIT_ASSERT_VALUES_EQUAL(left.GetNdv(), right.GetNdv());
+    }
+    if (left.HasBucketNdv()) {
+        for (ui32 i = 0; i < left.GetNumBuckets(); ++i) {
+            UNIT_ASSERT_VALUES_EQUAL(left.GetBucketNdv(i), right.GetBucketNdv(i));
+        }
+    }
+}
+
+void CheckRoundTrip(const TEqWidthHistogram& histogram, EHistogramFormat format) {
+    ui64 size = 0;
+    const auto data = histogram.Serialize(size, format);
+    UNIT_ASSERT_VALUES_EQUAL(size, histogram.GetSerializedSize(format));
+    CheckEqual(histogram, TEqWidthHistogram(data.get(), size));
+
+    TStringStream stream;
+    histogram.SerializeTo(stream, format);
+    UNIT_ASSERT_VALUES_EQUAL(stream.Str(), TString(data.get(), size));
+
+    TVector<char> buffer(size);
+    UNIT_ASSERT_VALUES_EQUAL(histogram.SerializeTo(TArrayRef<char>(buffer), format), size);
+    UNIT_ASSERT_VALUES_EQUAL(TString(buffer.data(), buffer.size()), TString(data.get(), size));
+}
+
+// Checks that the given `adaptive` histogram grown by `values` counts them as a histogram built on
+// its final layout does.
+void CheckMatchesFreshHistogram(const TEqWidthHistogram& adaptive, const TVector<i32>& values) {
+    UNIT_ASSERT(adaptive.IsEqWidthLayout());
+    const auto starts = adaptive.GetStarts<i32>();
+    UNIT_ASSERT(!CmpLess<i32>(*std::min_element(values.begin(), values.end()), starts[0]));
+    auto fresh = MakeHistogram<i32>(TVector<i32>(starts.begin(), starts.end()));
+    for (const auto val : values) {
+        fresh.AddElement<i32>(val);
+    }
+    CheckEqual(adaptive, fresh);
+}
+
+} // namespace
+
+Y_UNIT_TEST_SUITE(EqWidthHistogram) {
+    Y_UNIT_TEST(AddElementsMatchesAddElement) {
+        CheckAddElementsMatchesAddElement<i32>(MakeEqWidthHistogram<i32>(10, 0, 99), -50, 200);
+        CheckAddElementsMatchesAddElement<i16>(MakeEqWidthHistogram<i16>(10, -100, -91), -400, 100);
+        CheckAddElementsMatchesAddElement<ui64>(MakeEqWidthHistogram<ui64>(7, 0, 1000), 0, 100000);
+        CheckAddElementsMatchesAddElement<i64>(MakeEqWidthHistogram<i64>(1, -1000, 1000), -100000, 100000);
+        CheckAddElementsMatchesAddElement<double>(MakeEqWidthHistogram<double>(100, 0.0, 0.1), -1.0, 12.0);
+        CheckAddElementsMatchesAddElement<float>(MakeEqWidthHistogram<float>(16, -1.0f, 1.0f), -2.0f, 2.0f);
+        CheckAddElementsMatchesAddElement<ui32>(MakeEqWidthHistogram<ui32>(1 << 16, 0, 1 << 20), 0, 2 << 20);
+        // Not an equal-width layout.
+        CheckAddElementsMatchesAddElement<i32>(MakeHistogram<i32>({0, 1, 5, 20, 100}), -10, 200);
+    }
+
+    Y_UNIT_TEST(EqWidthLayoutIsDetected) {
+        UNIT_ASSERT(MakeEqWidthHistogram<i32>(10, 0, 99).IsEqWidthLayout());
+        UNIT_ASSERT(MakeEqWidthHistogram<double>(10, -1.0, 1.0).IsEqWidthLayout());
+        UNIT_ASSERT(!MakeHistogram<i32>({0, 1, 5, 20, 100}).IsEqWidthLayout());
+        UNIT_ASSERT(!MakeHistogram<i32>({7}).IsEqWidthLayout());
+    }
+
+    Y_UNIT_TEST(BucketIndicesMatchBinarySearch) {
+        CheckBucketIndices<i32>(MakeEqWidthHistogram<i32>(10, 0, 99), -50, 200);
+        CheckBucketIndices<ui64>(MakeEqWidthHistogram<ui64>(3, 0, std::numeric_limits<ui64>::max()), 0, std::numeric_limits<ui64>::max());
+        CheckBucketIndices<i64>(MakeEqWidthHistogram<i64>(5, std::numeric_limits<i64>::min(), std::numeric_limits<i64>::max()),
+                                std::numeric_limits<i64>::min(), std::numeric_limits<i64>::max());
+        CheckBucketIndices<double>(MakeEqWidthHistogram<double>(33, -3.3, 1.7), -10.0, 30.0);
+        CheckBucketIndices<i32>(MakeHistogram<i32>({0, 1, 5, 20, 100}), -10, 200);
+    }
+
+    Y_UNIT_TEST(NanGoesToFirstBucket) {
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        for (auto histogram : {MakeEqWidthHistogram<double>(1000, -1.0, 1.0), MakeHistogram<double>({-1.0, 0.0, 0.5, 1.0})}) {
+            UNIT_ASSERT_VALUES_EQUAL(histogram.FindBucketIndex<double>(nan), 0);
+            UNIT_ASSERT_VALUES_EQUAL(histogram.FindContainingBucketIndex<double>(nan), 0);
+            UNIT_ASSERT_VALUES_EQUAL(histogram.AddElement<double>(nan), 0);
+            const TVector<double> values(100, nan);
+            histogram.AddElements<double>(values);
+            UNIT_ASSERT_VALUES_EQUAL(histogram.GetNumElementsInBucket(0), 101);
+        }
+    }
+
+    Y_UNIT_TEST(InitializeBuckets) {
+        TEqWidthHistogram histogram(10, EHistogramValueType::Int32);
+        TEqWidthHistogram::TBucketRange range;
+        StoreTo<i32>(range.Start, 0);
+        StoreTo<i32>(range.End, 99);
+        histogram.InitializeBuckets<i32>(range);
+        UNIT_ASSERT(histogram.IsEqWidthLayout());
+        for (ui32 i = 0; i < 10; ++i) {
+            UNIT_ASSERT_VALUES_EQUAL(histogram.GetBucketStart<i32>(i), static_cast<i32>(i * 10));
+        }
+
+        // Fewer values than buckets, the rest of buckets have the unit width.
+        StoreTo<i32>(range.End, 3);
+        histogram.InitializeBuckets<i32>(range);
+        for (ui32 i = 0; i < 10; ++i) {
+            UNIT_ASSERT_VALUES_EQUAL(histogram.GetBucketStart<i32>(i), static_cast<i32>(i));
+        }
+
+        // Buckets past the maximum of the type are dropped, starts do not repeat.
+        StoreTo<i32>(range.Start, std::numeric_limits<i32>::max() - 2);
+        StoreTo<i32>(range.End, std::numeric_limits<i32>::max());
+        histogram.InitializeBuckets<i32>(range);
+        UNIT_ASSERT_VALUES_EQUAL(histogram.GetNumBuckets(), 3);
+        UNIT_ASSERT(histogram.IsEqWidthLayout());
+        UNIT_ASSERT_VALUES_EQUAL(histogram.GetBucketStart<i32>(2), std::numeric_limits<i32>::max());
+        UNIT_ASSERT_VALUES_EQUAL(histogram.FindBucketIndex<i32>(std::numeric_limits<i32>::max()), 2);
+
+        TEqWidthHistogram shorts(4, EHistogramValueType::Int16);
+        StoreTo<i16>(range.Start, 32766);
+        StoreTo<i16>(range.End, 32767);
+        shorts.InitializeBuckets<i16>(range);
+        UNIT_ASSERT_VALUES_EQUAL(shorts.GetNumBuckets(), 2);
+        UNIT_ASSERT_VALUES_EQUAL(shorts.AddElement<i16>(32767), 1);
+        UNIT_ASSERT_VALUES_EQUAL(shorts.AddElement<i16>(32766), 0);
+
+        TEqWidthHistogramT<i16> typed(4);
+        typed.InitializeBuckets(32766, 32767);
+        UNIT_ASSERT_VALUES_EQUAL(typed.GetNumBuckets(), 2);
+        UNIT_ASSERT_VALUES_EQUAL(typed.GetBucketStart(1), 32767);
+    }
+
+    Y_UNIT_TEST(SerializeRoundTrip) {
+        for (const auto format : {EHistogramFormat::V1, EHistogramFormat::V2}) {
+            auto histogram = MakeEqWidthHistogram<i32>(10, 0, 99);
+            histogram.AddElements<i32>(MakeValues<i32>(histogram, 1000, -10, 110));
+            CheckRoundTrip(histogram, format);
+
+            auto doubles = MakeEqWidthHistogram<double>(20, -1.0, 1.0);
+            doubles.AddElements<double>(MakeValues<double>(doubles, 1000, -1.0, 1.0));
+            CheckRoundTrip(doubles, format);
+
+            auto irregular = MakeHistogram<ui16>({0, 1, 5, 20, 100}, EHistogramValueType::Date);
+            irregular.AddElements<ui16>(MakeValues<ui16>(irregular, 1000, 0, 200));
+            CheckRoundTrip(irregular, format);
+        }
+    }
+
+    Y_UNIT_TEST(SerializeV2WithNdv) {
+        auto histogram = MakeEqWidthHistogram<i64>(8, 0, 799);
+        histogram.EnableNdv(10, 4);
+        histogram.AddElements<i64>(MakeValues<i64>(histogram, 1000, 0, 799));
+        CheckRoundTrip(histogram, EHistogramFormat::V2);
+    }
+
+    Y_UNIT_TEST(MalformedDataThrows) {
+        auto histogram = MakeEqWidthHistogram<i32>(10, 0, 99);
+        histogram.EnableNdv(10, 4);
+        histogram.AddElements<i32>(MakeValues<i32>(histogram, 100, 0, 99));
+        const auto check = [](TString data, ui64 offset, ui8 byte) {
+            data[offset] = static_cast<char>(byte);
+            UNIT_ASSERT_EXCEPTION(TEqWidthHistogram(data.data(), data.size()), yexception);
+        };
+
+        TStringStream v1;
+        histogram.SerializeTo(v1, EHistogramFormat::V1);
+        // The value type.
+        check(v1.Str(), sizeof(ui32), 200);
+        UNIT_ASSERT_EXCEPTION(TEqWidthHistogram(v1.Data(), v1.Size() - 1), yexception);
+
+        TStringStream v2;
+        histogram.SerializeTo(v2, EHistogramFormat::V2);
+        // The version, the value type and the highest byte of the number of buckets.
+        check(v2.Str(), sizeof(ui32), 9);
+        check(v2.Str(), sizeof(ui32) + 1, 200);
+        check(v2.Str(), sizeof(ui32) + 6, 0xFF);
+        for (ui64 size = 0; size < v2.Size(); ++size) {
+            UNIT_ASSERT_EXCEPTION(TEqWidthHistogram(v2.Data(), size), yexception);
+        }
+        const TString trailing = v2.Str() + '\0';
+        UNIT_ASSERT_EXCEPTION(TEqWidthHistogram(trailing.data(), trailing.size()), yexception);
+        UNIT_ASSERT_NO_EXCEPTION(TEqWidthHistogram(v2.Data(), v2.Size()));
+
+        // A varint of more than 64 bits.
+        ui64 value = 0;
+        const TString maxVarint = TString(9, '\xFF') + '\x01';
+        UNIT_ASSERT(NPrivate::ReadVarint(maxVarint.data(), maxVarint.data() + maxVarint.size(), value) == maxVarint.data() + maxVarint.size());
+        UNIT_ASSERT_VALUES_EQUAL(value, std::numeric_limits<ui64>::max());
+        for (const char last : {'\x02', '\x7F', '\x81'}) {
+            const TString overflowed = TString(9, '\xFF') + last + '\x00';
+            UNIT_ASSERT_EXCEPTION(NPrivate::ReadVarint(overflowed.data(), overflowed.data() + overflowed.size(), value), yexception);
+        }
+    }
+
+    Y_UNIT_TEST(SerializeV2IsCompact) {
+        auto histogram = MakeEqWidthHistogram<i32>(256, 0, 1 << 20);
+        histogram.AddElements<i32>(MakeValues<i32>(histogram, 1000, 0, 1 << 20));
+        UNIT_ASSERT_LT(histogram.GetSerializedSize(EHistogramFormat::V2) * 4, histogram.GetSerializedSize(EHistogramFormat::V1));
+    }
+
+    Y_UNIT_TEST(AdaptiveGrowthMatchesFreshHistogram) {
+        const auto values = MakeValues<i32>(MakeEqWidthHistogram<i32>(10, 0, 99), 10000, -500, 2000);
+        auto adaptive = MakeEqWidthHistogram<i32>(10, 0, 99);
+        for (const auto val : values) {
+            adaptive.AddElementAdaptive<i32>(val);
+        }
+        CheckMatchesFreshHistogram(adaptive, values);
+
+        // The range grows in another order, so the layout could differ.
+        auto batch = MakeEqWidthHistogram<i32>(10, 0, 99);
+        for (size_t i = 0; i < values.size(); i += 100) {
+            batch.AddElementsAdaptive<i32>(TArrayRef<const i32>(values).subspan(i, std::min<size_t>(100, values.size() - i)));
+        }
+        CheckMatchesFreshHistogram(batch, values);
+    }
+
+    Y_UNIT_TEST(AdaptiveGrowsUpIfCanNotGrowDown) {
+        constexpr i16 lowest = std::numeric_limits<i16>::lowest();
+        const i16 first = lowest + 8;
+        for (const bool batch : {false, true}) {
+            auto histogram = MakeEqWidthHistogram<i16>(10, first, first + 99);
+            const TVector<i16> values = {lowest, 0};
+            if (batch) {
+                UNIT_ASSERT(histogram.AddElementsAdaptive<i16>(values));
+            } else {
+                UNIT_ASSERT(!histogram.AddElementAdaptive<i16>(lowest));
+                UNIT_ASSERT(histogram.AddElementAdaptive<i16>(0));
+            }
+            UNIT_ASSERT(histogram.IsEqWidthLayout());
+            UNIT_ASSERT_VALUES_EQUAL(histogram.GetBucketStart<i16>(0), first);
+            const auto last = histogram.GetNumBuckets() - 1;
+            UNIT_ASSERT_LT(0, histogram.GetBucketStart<i16>(last) + static_cast<i32>(histogram.GetBucketWidth<i16>()));
+            UNIT_ASSERT_VALUES_EQUAL(histogram.GetNumElementsInBucket(0), 1);
+            UNIT_ASSERT_VALUES_EQUAL(histogram.GetNumElementsInBucket(histogram.FindContainingBucketIndex<i16>(0)), 1);
+        }
+    }
+
+    Y_UNIT_TEST(RebucketKeepsTotal) {
+        auto histogram = MakeEqWidthHistogram<i32>(10, 0, 99);
+        histogram.AddElements<i32>(MakeValues<i32>(histogram, 1000, 0, 99));
+        const ui64 total = 1000 + 10;
+        UNIT_ASSERT(histogram.Rebucket<i32>(4));
+        UNIT_ASSERT_VALUES_EQUAL(histogram.GetNumBuckets(), 4);
+        UNIT_ASSERT(histogram.IsEqWidthLayout());
+        const auto counts = histogram.GetCounts();
+        UNIT_ASSERT_VALUES_EQUAL(std::accumulate(counts.begin(), counts.end(), 0ULL), total);
+    }
+
+    Y_UNIT_TEST(AggregateDifferentLayouts) {
+        auto left = MakeEqWidthHistogram<i32>(10, 0, 99);
+        left.AddElements<i32>(MakeValues<i32>(left, 1000, 0, 99));
+        auto right = MakeEqWidthHistogram<i32>(10, 50, 249);
+        right.AddElements<i32>(MakeValues<i32>(right, 1000, 50, 249, 2));
+        auto same = left;
+        UNIT_ASSERT(same.Aggregate<i32>(left));
+        for (ui32 i = 0; i < left.GetNumBuckets(); ++i) {
+            UNIT_ASSERT_VALUES_EQUAL(same.GetNumElementsInBucket(i), 2 * left.GetNumElementsInBucket(i));
+        }
+
+        UNIT_ASSERT(left.Aggregate<i32>(right));
+        UNIT_ASSERT_VALUES_EQUAL(left.GetNumBuckets(), 10);
+        UNIT_ASSERT_VALUES_EQUAL(left.GetBucketStart<i32>(0), 0);
+        UNIT_ASSERT(!CmpLess<i32>(left.GetBucketStart<i32>(9), 200));
+        const auto counts = left.GetCounts();
+        UNIT_ASSERT_VALUES_EQUAL(std::accumulate(counts.begin(), counts.end(), 0ULL), 2020);
+
+        UNIT_ASSERT(!left.Aggregate<i32>(MakeHistogram<i64>({0, 10})));
+    }
+
+    Y_UNIT_TEST(Ndv) {
+        auto histogram = MakeEqWidthHistogram<i32>(10, 0, 99);
+        histogram.EnableNdv(12, 8);
+        for (ui32 repeat = 0; repeat < 10; ++repeat) {
+            for (i32 val = 0; val < 100; ++val) {
+                histogram.AddElement<i32>(val);
+            }
+        }
+        UNIT_ASSERT_DOUBLES_EQUAL(histogram.GetNdv(), 100.0, 5.0);
+        for (ui32 i = 0; i < 10; ++i) {
+            UNIT_ASSERT_DOUBLES_EQUAL(histogram.GetBucketNdv(i), 10.0, 2.0);
+        }
+        histogram.DisableNdv();
+        UNIT_ASSERT(!histogram.HasNdv());
+    }
+
+    Y_UNIT_TEST(TypedMatchesTypeErased) {
+        const auto histogram = MakeEqWidthHistogram<double>(10, 0.0, 1.0);
+        TEqWidthHistogramT<double> typed(histogram);
+        auto erased = histogram;
+        const auto values = MakeValues<double>(histogram, 1000, -0.5, 1.5);
+        typed.AddElements(values);
+        erased.AddElements<double>(values);
+        CheckEqual(typed.ToHistogram(), erased);
+        for (const auto val : values) {
+            UNIT_ASSERT_VALUES_EQUAL(typed.FindBucketIndex(val), erased.FindBucketIndex<double>(val));
+            UNIT_ASSERT_VALUES_EQUAL(typed.FindContainingBucketIndex(val), erased.FindContainingBucketIndex<double>(val));
+        }
+    }
+
+    Y_UNIT_TEST(TypedAggregateMatchesTypeErased) {
+        for (const i32 otherMin : {0, 50}) {
+            auto left = MakeEqWidthHistogram<i32>(10, 0, 99);
+            left.AddElements<i32>(MakeValues<i32>(left, 1000, 0, 99));
+            auto right = MakeEqWidthHistogram<i32>(10, otherMin, otherMin + 199);
+            right.AddElements<i32>(MakeValues<i32>(right, 1000, otherMin, otherMin + 199, 2));
+            TEqWidthHistogramT<i32> typed(left);
+            UNIT_ASSERT(typed.Aggregate(TEqWidthHistogramT<i32>(right)));
+            UNIT_ASSERT(left.Aggregate<i32>(right));
+            CheckEqual(typed.ToHistogram(), left);
+        }
+        TEqWidthHistogramT<ui16> dates(10, EHistogramValueType::Date);
+        UNIT_ASSERT(!dates.Aggregate(TEqWidthHistogramT<ui16>(10)));
+    }
+
+    Y_UNIT_TEST(WideBuckets) {
+        // Widths and per value estimates do not fit `ui32`.
+        auto histogram = std::make_shared<TEqWidthHistogram>(MakeEqWidthHistogram<ui64>(4, 0, (1ULL << 40) - 1));
+        UNIT_ASSERT_VALUES_EQUAL(histogram->GetBucketWidth<ui64>(), 1ULL << 38);
+        histogram->AddToBucket(0, 1ULL << 50);
+        const TEqWidthHistogramEstimator estimator(histogram);
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateEqual<ui64>(42), 1ULL << 12);
+        UNIT_ASSERT_VALUES_EQUAL(MakeEqWidthHistogram<i64>(2, std::numeric_limits<i64>::min(), std::numeric_limits<i64>::max()).GetBucketWidth<i64>(),
+                                 1ULL << 63);
+    }
+
+    Y_UNIT_TEST(FloatLayout) {
+        for (const auto& histogram : {MakeEqWidthHistogram<float>(16, -1.0f, 1.0f), MakeEqWidthHistogram<float>(10, 0.1f, 1.7f)}) {
+            UNIT_ASSERT(histogram.IsEqWidthLayout());
+            UNIT_ASSERT_VALUES_EQUAL(histogram.GetBucketWidth<float>(), 1);
+            CheckBucketIndices<float>(histogram, -2.0f, 2.0f);
+            CheckAddElementsMatchesAddElement<float>(histogram, -2.0f, 2.0f);
+            auto filled = histogram;
+            filled.AddElements<float>(MakeValues<float>(filled, 1000, -2.0f, 2.0f));
+            CheckRoundTrip(filled, EHistogramFormat::V1);
+            CheckRoundTrip(filled, EHistogramFormat::V2);
+        }
+        UNIT_ASSERT(!MakeHistogram<float>({0.0f, 0.5f, 2.0f, 2.5f}).IsEqWidthLayout());
+    }
+
+    Y_UNIT_TEST(StringValues) {
+        UNIT_ASSERT_VALUES_EQUAL(StringToHistogramValue(""), 0);
+        UNIT_ASSERT_VALUES_EQUAL(StringToHistogramValue("\x01"), 1ULL << 56);
+        UNIT_ASSERT_VALUES_EQUAL(StringToHistogramValue("abcdefgh"), 0x6162636465666768ULL);
+        // Only the prefix is kept.
+        UNIT_ASSERT_VALUES_EQUAL(StringToHistogramValue("abcdefgh1"), StringToHistogramValue("abcdefgh2"));
+        const TVector<TString> sorted = {"", "a", "a\x01", "ab", "b", "ba", "zzzzzzzz", "\xff"};
+        for (size_t i = 1; i < sorted.size(); ++i) {
+            UNIT_ASSERT_LT(StringToHistogramValue(sorted[i - 1]), StringToHistogramValue(sorted[i]));
+        }
+
+        auto histogram = MakeHistogram<ui64>({StringToHistogramValue(""), StringToHistogramValue("h"), StringToHistogramValue("p")},
+                                             EHistogramValueType::String);
+        for (const TStringBuf str : {"apple", "banana", "hello", "ocean", "pear", "zebra", ""}) {
+            histogram.AddElement<ui64>(StringToHistogramValue(str));
+        }
+        UNIT_ASSERT_VALUES_EQUAL(histogram.GetNumElementsInBucket(0), 3);
+        UNIT_ASSERT_VALUES_EQUAL(histogram.GetNumElementsInBucket(1), 2);
+        UNIT_ASSERT_VALUES_EQUAL(histogram.GetNumElementsInBucket(2), 2);
+        CheckRoundTrip(histogram, EHistogramFormat::V2);
+    }
+
+    Y_UNIT_TEST(DecimalValues) {
+        UNIT_ASSERT_DOUBLES_EQUAL(DecimalToHistogramValue(12345, 2), 123.45, 1e-9);
+        UNIT_ASSERT_DOUBLES_EQUAL(DecimalToHistogramValue(-5, 0), -5.0, 1e-9);
+        UNIT_ASSERT_DOUBLES_EQUAL(DecimalToHistogramValue(1, 10), 1e-10, 1e-20);
+
+        auto histogram = MakeHistogram<double>(NPrivate::MakeEqWidthStarts<double>(0.0, 100.0, 10), EHistogramValueType::Decimal);
+        UNIT_ASSERT(histogram.IsEqWidthLayout());
+        // 0.00, 0.25, ..., 99.75.
+        for (i64 unscaled = 0; unscaled < 10000; unscaled += 25) {
+            histogram.AddElement<double>(DecimalToHistogramValue(unscaled, 2));
+        }
+        for (ui32 i = 0; i < histogram.GetNumBuckets(); ++i) {
+            UNIT_ASSERT_VALUES_EQUAL(histogram.GetNumElementsInBucket(i), 40);
+        }
+        CheckRoundTrip(histogram, EHistogramFormat::V1);
+        CheckRoundTrip(histogram, EHistogramFormat::V2);
+    }
+}
+
+} // namespace NKikimr
@@ -0,0 +1,128 @@
+#include <yql/essentials/core/histogram/eq_width_histogram_view.h>
+
+#include <library/cpp/testing/unittest/registar.h>
+
+namespace NKikimr {
+
+namespace {
+
+template <typename T>
+std::shared_ptr<TEqWidthHistogram> MakeHistogram(TVector<T> starts) {
+    const TVector<ui64> counts(starts.size());
+    return std::make_shared<TEqWidthHistogram>(GetHistogramValueType<T>(), TArrayRef<const T>(starts), TArrayRef<const ui64>(counts));
+}
+
+template <typename T>
+void CheckViewMatchesEstimator(std::shared_ptr<TEqWidthHistogram> histogram, const TVector<T>& probes, EHistogramFormat format) {
+    ui64 size = 0;
+    const auto data = histogram->Serialize(size, format);
+    const TEqWidthHistogramView view(data.get(), size);
+    const TEqWidthHistogramEstimator estimator(histogram);
+    UNIT_ASSERT_VALUES_EQUAL(view.GetNumBuckets(), histogram->GetNumBuckets());
+    UNIT_ASSERT(view.GetType() == histogram->GetType());
+    for (ui32 i = 0; i < histogram->GetNumBuckets(); ++i) {
+        UNIT_ASSERT_VALUES_EQUAL(view.GetBucketStart<T>(i), histogram->GetBucketStart<T>(i));
+        UNIT_ASSERT_VALUES_EQUAL(view.GetNumElementsInBucket(i), histogram->GetNumElementsInBucket(i));
+    }
+    UNIT_ASSERT_VALUES_EQUAL(view.GetNumElements(), estimator.GetNumElements());
+    for (const auto val : probes) {
+        UNIT_ASSERT_VALUES_EQUAL(view.FindBucketIndex<T>(val), histogram->FindBucketIndex<T>(val));
+        UNIT_ASSERT_VALUES_EQUAL(view.EstimateLessOrEqual<T>(val), estimator.EstimateLessOrEqual<T>(val));
+        UNIT_ASSERT_VALUES_EQUAL(view.EstimateLess<T>(val), estimator.EstimateLess<T>(val));
+        UNIT_ASSERT_VALUES_EQUAL(view.EstimateGreaterOrEqual<T>(val), estimator.EstimateGreaterOrEqual<T>(val));
+        UNIT_ASSERT_VALUES_EQUAL(view.EstimateGreater<T>(val), estimator.EstimateGreater<T>(val));
+        UNIT_ASSERT_VALUES_EQUAL(view.EstimateEqual<T>(val), estimator.EstimateEqual<T>(val));
+    }
+}
+
+} // namespace
+
+Y_UNIT_TEST_SUITE(EqWidthHistogramView) {
+    Y_UNIT_TEST(MatchesEstimator) {
+        TVector<i32> probes;
+        for (i32 val = -20; val < 220; val += 3) {
+            probes.push_back(val);
+        }
+        for (const auto format : {EHistogramFormat::V1, EHistogramFormat::V2}) {
+            for (const auto& starts : {NPrivate::MakeEqWidthStarts<i32>(0, 199, 20), TVector<i32>{0, 1, 5, 20, 100}, TVector<i32>{42}}) {
+                auto histogram = MakeHistogram<i32>(starts);
+                for (i32 val = -10; val < 210; ++val) {
+                    histogram->AddElement<i32>(val);
+                }
+                CheckViewMatchesEstimator<i32>(histogram, probes, format);
+            }
+
+            auto doubles = MakeHistogram<double>(NPrivate::MakeEqWidthStarts<double>(-1.0, 1.0, 16));
+            for (ui32 i = 0; i < 1000; ++i) {
+                doubles->AddElement<double>(i / 500.0 - 1);
+            }
+            CheckViewMatchesEstimator<double>(doubles, {-2.0, -1.0, -0.5, 0.0, 0.125, 0.3, 1.0, 2.0}, format);
+        }
+    }
+
+    Y_UNIT_TEST(MalformedDataThrows) {
+        auto histogram = MakeHistogram<i32>(NPrivate::MakeEqWidthStarts<i32>(0, 99, 10));
+        for (const auto format : {EHistogramFormat::V1, EHistogramFormat::V2}) {
+            ui64 size = 0;
+            const auto data = histogram->Serialize(size, format);
+            TString bad(data.get(), size);
+            // The value type.
+            bad[format == EHistogramFormat::V1 ? sizeof(ui32) : sizeof(ui32) + 1] = static_cast<char>(200);
+            UNIT_ASSERT_EXCEPTION(TEqWidthHistogramView(bad.data(), bad.size()), yexception);
+            UNIT_ASSERT_EXCEPTION(TEqWidthHistogramView(data.get(), size - 1), yexception);
+        }
+
+        // Varint counts are decoded on construction, a truncated last count throws there.
+        for (ui32 i = 0; i < 1000; ++i) {
+            histogram->AddElement<i32>(99);
+        }
+        ui64 size = 0;
+        const auto data = histogram->Serialize(size, EHistogramFormat::V2);
+        UNIT_ASSERT_EXCEPTION(TEqWidthHistogramView(data.get(), size - 1), yexception);
+    }
+
+    Y_UNIT_TEST(CopyAndMove) {
+        static_assert(std::is_nothrow_move_constructible_v<TEqWidthHistogramView>);
+        auto histogram = MakeHistogram<i32>(NPrivate::MakeEqWidthStarts<i32>(0, 99, 10));
+        for (i32 val = 0; val < 100; ++val) {
+            histogram->AddElement<i32>(val);
+        }
+        TVector<std::unique_ptr<char[]>> buffers;
+        TVector<TEqWidthHistogramView> views;
+        for (const auto format : {EHistogramFormat::V1, EHistogramFormat::V2}) {
+            ui64 size = 0;
+            buffers.push_back(histogram->Serialize(size, format));
+            TEqWidthHistogramView view(buffers.back().get(), size);
+            views.push_back(view);
+            views.push_back(std::move(view));
+        }
+        for (const auto& view : views) {
+            UNIT_ASSERT_VALUES_EQUAL(view.GetNumElements(), 100);
+            UNIT_ASSERT_VALUES_EQUAL(view.GetBucketStart<i32>(3), 30);
+            UNIT_ASSERT_VALUES_EQUAL(view.EstimateLessOrEqual<i32>(40), 50);
+        }
+    }
+
+    Y_UNIT_TEST(WideBuckets) {
+        auto histogram = MakeHistogram<ui64>(NPrivate::MakeEqWidthStarts<ui64>(0, (1ULL << 40) - 1, 4));
+        histogram->AddToBucket(0, 1ULL << 50);
+        for (const auto format : {EHistogramFormat::V1, EHistogramFormat::V2}) {
+            CheckViewMatchesEstimator<ui64>(histogram, {0, 42, 1ULL << 39, 1ULL << 41}, format);
+        }
+    }
+
+    Y_UNIT_TEST(IgnoresNdv) {
+        auto histogram = MakeHistogram<i32>(NPrivate::MakeEqWidthStarts<i32>(0, 99, 10));
+        histogram->EnableNdv(10, 4);
+        for (i32 val = 0; val < 100; ++val) {
+            histogram->AddElement<i32>(val);
+        }
+        ui64 size = 0;
+        const auto data = histogram->Serialize(size, EHistogramFormat::V2);
+        const TEqWidthHistogramView view(data.get(), size);
+        UNIT_ASSERT_VALUES_EQUAL(view.GetNumElements(), 100);
+        UNIT_ASSERT_VALUES_EQUAL(view.EstimateLessOrEqual<i32>(40), 50);
+    }
+}
+
+} // namespace NKikimr
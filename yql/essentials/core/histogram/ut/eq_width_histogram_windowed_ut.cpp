@@ -0,0 +1,51 @@
+#include <yql/essentials/core/histogram/eq_width_histogram_windowed.h>
+
+#include <library/cpp/testing/unittest/registar.h>
+
+namespace NKikimr {
+
+namespace {
+
+TEqWidthHistogram MakeLayout() {
+    const auto starts = NPrivate::MakeEqWidthStarts<i32>(0, 99, 10);
+    const TVector<ui64> counts(starts.size(), 100);
+    return TEqWidthHistogram(EHistogramValueType::Int32, TArrayRef<const i32>(starts), TArrayRef<const ui64>(counts));
+}
+
+ui64 GetTotal(const TWindowedEqWidthHistogram& histogram) {
+    const auto counts = histogram.GetHistogram().GetCounts();
+    return std::accumulate(counts.begin(), counts.end(), 0ULL);
+}
+
+} // namespace
+
+Y_UNIT_TEST_SUITE(WindowedEqWidthHistogram) {
+    Y_UNIT_TEST(OldEpochsLeaveWindow) {
+        TWindowedEqWidthHistogram histogram(MakeLayout(), 3);
+        UNIT_ASSERT_VALUES_EQUAL(GetTotal(histogram), 0);
+        for (ui32 epoch = 0; epoch < 5; ++epoch) {
+            histogram.AdvanceTo(epoch);
+            UNIT_ASSERT_VALUES_EQUAL(histogram.GetEpoch(), epoch);
+            TVector<i32> values(epoch + 1, static_cast<i32>(epoch * 10));
+            histogram.AddElements<i32>(values);
+            histogram.AddElement<i32>(static_cast<i32>(epoch * 10 + 5));
+        }
+        // Epochs 2, 3 and 4.
+        UNIT_ASSERT_VALUES_EQUAL(GetTotal(histogram), 4 + 5 + 6);
+        UNIT_ASSERT_VALUES_EQUAL(histogram.GetHistogram().GetNumElementsInBucket(1), 0);
+        UNIT_ASSERT_VALUES_EQUAL(histogram.GetHistogram().GetNumElementsInBucket(4), 6);
+
+        // An older epoch is ignored.
+        histogram.AdvanceTo(1);
+        UNIT_ASSERT_VALUES_EQUAL(histogram.GetEpoch(), 4);
+
+        histogram.Advance();
+        UNIT_ASSERT_VALUES_EQUAL(GetTotal(histogram), 5 + 6);
+        histogram.AdvanceTo(100);
+        UNIT_ASSERT_VALUES_EQUAL(GetTotal(histogram), 0);
+        histogram.AddElement<i32>(50);
+        UNIT_ASSERT_VALUES_EQUAL(GetTotal(histogram), 1);
+    }
+}
+
+} // namespace NKikimr
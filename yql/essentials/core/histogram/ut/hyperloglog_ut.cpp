@@ -0,0 +1,63 @@
+#include <yql/essentials/core/histogram/hyperloglog.h>
+
+#include <library/cpp/testing/unittest/registar.h>
+
+#include <util/generic/string.h>
+
+namespace NKikimr {
+
+Y_UNIT_TEST_SUITE(HyperLogLogSketch) {
+    Y_UNIT_TEST(Estimate) {
+        for (const ui64 numDistinct : {0ULL, 1ULL, 10ULL, 1000ULL, 100000ULL}) {
+            THyperLogLogSketch sketch(12);
+            for (ui32 repeat = 0; repeat < 3; ++repeat) {
+                for (ui64 val = 0; val < numDistinct; ++val) {
+                    sketch.AddValue<ui64>(val);
+                }
+            }
+            // 1.6% standard error.
+            UNIT_ASSERT_DOUBLES_EQUAL(sketch.Estimate(), numDistinct, numDistinct * 0.05 + 0.5);
+        }
+    }
+
+    Y_UNIT_TEST(Merge) {
+        THyperLogLogSketch left(10);
+        THyperLogLogSketch right(10);
+        THyperLogLogSketch both(10);
+        for (i64 val = 0; val < 20000; ++val) {
+            (val % 2 ? left : right).AddValue<i64>(val / 3);
+            both.AddValue<i64>(val / 3);
+        }
+        UNIT_ASSERT(left.Merge(right));
+        UNIT_ASSERT_VALUES_EQUAL(left.Estimate(), both.Estimate());
+        UNIT_ASSERT(!left.Merge(THyperLogLogSketch(11)));
+    }
+
+    Y_UNIT_TEST(ZeroSigns) {
+        THyperLogLogSketch sketch(10);
+        sketch.AddValue<double>(0.0);
+        sketch.AddValue<double>(-0.0);
+        UNIT_ASSERT_VALUES_EQUAL(sketch.Estimate(), 1);
+    }
+
+    Y_UNIT_TEST(SerializeRoundTrip) {
+        THyperLogLogSketch sketch(8);
+        for (ui32 val = 0; val < 1000; ++val) {
+            sketch.AddValue<ui32>(val);
+        }
+        TString data;
+        sketch.SerializeTo([&data](const void* part, ui64 size) {
+            data.append(static_cast<const char*>(part), size);
+        });
+        UNIT_ASSERT_VALUES_EQUAL(data.size(), sketch.GetSerializedSize());
+        THyperLogLogSketch copy;
+        UNIT_ASSERT_VALUES_EQUAL(copy.Deserialize(data.data(), data.data() + data.size()), data.data() + data.size());
+        UNIT_ASSERT_VALUES_EQUAL(copy.GetPrecision(), 8);
+        UNIT_ASSERT_VALUES_EQUAL(copy.Estimate(), sketch.Estimate());
+        UNIT_ASSERT_EXCEPTION(copy.Deserialize(data.data(), data.data() + data.size() - 1), yexception);
+        data[0] = 1;
+        UNIT_ASSERT_EXCEPTION(copy.Deserialize(data.data(), data.data() + data.size()), yexception);
+    }
+}
+
+} // namespace NKikimr
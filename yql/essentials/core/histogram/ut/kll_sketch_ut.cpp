@@ -0,0 +1,79 @@
+#include <yql/essentials/core/histogram/kll_sketch.h>
+
+#include <library/cpp/testing/unittest/registar.h>
+
+#include <util/random/fast.h>
+
+namespace NKikimr {
+
+namespace {
+
+TVector<double> MakeValues(ui32 numValues, ui64 seed) {
+    TFastRng64 rng(seed);
+    TVector<double> values;
+    for (ui32 i = 0; i < numValues; ++i) {
+        const double x = rng.GenRandReal3();
+        values.push_back(x * x * 1000);
+    }
+    return values;
+}
+
+void CheckRanks(const TKllSketch<double>& sketch, TVector<double> values) {
+    std::sort(values.begin(), values.end());
+    UNIT_ASSERT_VALUES_EQUAL(sketch.GetNumValues(), values.size());
+    UNIT_ASSERT_VALUES_EQUAL(sketch.GetMin(), values.front());
+    UNIT_ASSERT_VALUES_EQUAL(sketch.GetMax(), values.back());
+    for (double val = 0; val <= 1000; val += 50) {
+        const double rank = std::upper_bound(values.begin(), values.end(), val) - values.begin();
+        UNIT_ASSERT_DOUBLES_EQUAL(sketch.GetRank(val), rank, values.size() * 0.02);
+    }
+}
+
+} // namespace
+
+Y_UNIT_TEST_SUITE(KllSketch) {
+    Y_UNIT_TEST(Ranks) {
+        const auto values = MakeValues(100000, 1);
+        TKllSketch<double> sketch;
+        sketch.AddElements(values);
+        sketch.Add(std::nan(""));
+        UNIT_ASSERT_LT(sketch.GetRetainedSize(), 2000);
+        CheckRanks(sketch, values);
+        UNIT_ASSERT_DOUBLES_EQUAL(sketch.GetQuantile(0.25), 62.5, 20.0);
+    }
+
+    Y_UNIT_TEST(Merge) {
+        const auto left = MakeValues(50000, 1);
+        const auto right = MakeValues(70000, 2);
+        TKllSketch<double> sketch;
+        sketch.AddElements(left);
+        TKllSketch<double> other(200, 3);
+        other.AddElements(right);
+        sketch.Merge(other);
+        auto values = left;
+        values.insert(values.end(), right.begin(), right.end());
+        CheckRanks(sketch, values);
+    }
+
+    Y_UNIT_TEST(ToHistograms) {
+        const auto values = MakeValues(100000, 1);
+        TKllSketch<double> sketch;
+        sketch.AddElements(values);
+
+        const auto eqWidth = sketch.ToEqWidthHistogram(10);
+        UNIT_ASSERT_VALUES_EQUAL(eqWidth.GetNumBuckets(), 10);
+        UNIT_ASSERT(eqWidth.IsEqWidthLayout());
+        const auto counts = eqWidth.GetCounts();
+        UNIT_ASSERT_VALUES_EQUAL(std::accumulate(counts.begin(), counts.end(), 0ULL), values.size());
+        // sqrt(0.1) of values are in the first bucket.
+        UNIT_ASSERT_DOUBLES_EQUAL(counts[0], std::sqrt(0.1) * values.size(), values.size() * 0.02);
+
+        const auto eqDepth = sketch.ToEqDepthHistogram(10);
+        UNIT_ASSERT_VALUES_EQUAL(eqDepth.GetNumBuckets(), 10);
+        for (ui32 i = 0; i < eqDepth.GetNumBuckets(); ++i) {
+            UNIT_ASSERT_DOUBLES_EQUAL(eqDepth.GetNumElementsInBucket(i), values.size() / 10.0, values.size() * 0.02);
+        }
+    }
+}
+
+} // namespace NKikimr
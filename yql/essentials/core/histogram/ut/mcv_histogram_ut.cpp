@@ -0,0 +1,65 @@
+#include <yql/essentials/core/histogram/mcv_histogram.h>
+
+#include <library/cpp/testing/unittest/registar.h>
+
+namespace NKikimr {
+
+namespace {
+
+// 1000 values of 7, 500 values of 42 and one of every value in [0, 1000).
+TVector<i32> MakeValues() {
+    TVector<i32> values;
+    for (i32 val = 0; val < 1000; ++val) {
+        values.push_back(val);
+        if (val % 2 == 0) {
+            values.push_back(42);
+        }
+        values.push_back(7);
+    }
+    return values;
+}
+
+} // namespace
+
+Y_UNIT_TEST_SUITE(McvEqWidthHistogram) {
+    Y_UNIT_TEST(SpaceSavingFindsFrequent) {
+        TSpaceSaving<i32> top(4);
+        for (const auto val : MakeValues()) {
+            top.Add(val);
+        }
+        UNIT_ASSERT_VALUES_EQUAL(top.GetNumValues(), 2500);
+        ui32 found = 0;
+        for (const auto& item : top.GetItems()) {
+            if (item.Value == 7 || item.Value == 42) {
+                UNIT_ASSERT_LE(item.Count - item.Error, item.Value == 7 ? 1001U : 501U);
+                UNIT_ASSERT_GE(item.Count, item.Value == 7 ? 1001U : 501U);
+                ++found;
+            }
+        }
+        UNIT_ASSERT_VALUES_EQUAL(found, 2);
+    }
+
+    Y_UNIT_TEST(Estimates) {
+        const auto starts = NPrivate::MakeEqWidthStarts<i32>(0, 999, 10);
+        const TVector<ui64> counts(starts.size());
+        const TEqWidthHistogram layout(EHistogramValueType::Int32, TArrayRef<const i32>(starts), TArrayRef<const ui64>(counts));
+        TMcvEqWidthHistogramBuilder<i32> builder(layout, 10);
+        builder.AddElements(MakeValues());
+        auto remainder = std::make_shared<TEqWidthHistogram>(layout);
+        auto mcv = builder.Finish(*remainder);
+        UNIT_ASSERT(mcv.Values == TVector<i32>({7, 42}));
+
+        TMcvEqWidthHistogramEstimator<i32> estimator(std::move(mcv), remainder, {.Interpolate = true});
+        UNIT_ASSERT_VALUES_EQUAL(estimator.GetNumElements(), 2500);
+        UNIT_ASSERT_DOUBLES_EQUAL(estimator.EstimateEqual(7), 1001.0, 5.0);
+        UNIT_ASSERT_DOUBLES_EQUAL(estimator.EstimateEqual(42), 501.0, 5.0);
+        UNIT_ASSERT_VALUES_EQUAL(estimator.EstimateEqual(500), 1);
+        UNIT_ASSERT_DOUBLES_EQUAL(estimator.EstimateLess(7), 7.0, 1.0);
+        UNIT_ASSERT_DOUBLES_EQUAL(estimator.EstimateLessOrEqual(7), 1008.0, 1.0);
+        UNIT_ASSERT_DOUBLES_EQUAL(estimator.EstimateRange(0, 99), 1600.0, 5.0);
+        UNIT_ASSERT_DOUBLES_EQUAL(estimator.EstimateGreater(500), 499.0, 2.0);
+        UNIT_ASSERT_DOUBLES_EQUAL(estimator.EstimateGreaterOrEqual(500), 500.0, 2.0);
+    }
+}
+
+} // namespace NKikimr